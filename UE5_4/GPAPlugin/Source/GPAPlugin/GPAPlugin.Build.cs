@@ -46,34 +46,18 @@ public class GPAPlugin : ModuleRules
 			new string[]
 			{
 				"Core",
-				"GPALibrary",
+				"GPAPluginRuntime",
 				"CoreUObject",
 				"Engine",
 				"InputCore",
-				"DesktopPlatform",
 				"Projects",
-				"RenderCore",
-				"InputDevice",
-				"MainFrame",
-				"DeveloperSettings",
-				"RHI"
+				"Slate",
+				"SlateCore",
+				"ToolMenus",
+				"EditorStyle",
+				"UnrealEd",
+				"WorkspaceMenuStructure"
 			}
 			);
-
-
-		if (Target.bBuildEditor == true)
-		{
-			//DynamicallyLoadedModuleNames.AddRange(new string[] { "LevelEditor" });
-			PublicDependencyModuleNames.AddRange(new string[]
-			{
-					"Slate",
-					"ToolMenus",
-					"SlateCore",
-					"EditorStyle",
-					"UnrealEd",
-					"MainFrame",
-					"GameProjectGeneration"
-			});
-		}
 	}
 }
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "SGPACaptureCatalog.h"
+#include "GPAPluginRuntimeModule.h"
+#include "HAL/PlatformProcess.h"
+#include "Widgets/Input/SSearchBox.h"
+#include "Widgets/Text/STextBlock.h"
+#include "Widgets/Views/SHeaderRow.h"
+#include "Widgets/Views/STableRow.h"
+
+#define LOCTEXT_NAMESPACE "SGPACaptureCatalog"
+
+namespace GPACaptureCatalogColumns
+{
+	static const FName Time("Time");
+	static const FName Map("Map");
+	static const FName Build("Build");
+	static const FName RHI("RHI");
+	static const FName Frames("Frames");
+	static const FName MeanMs("MeanMs");
+	static const FName MaxMs("MaxMs");
+	static const FName Tags("Tags");
+}
+
+/** One capture row, one text cell per column**/
+class SGPACaptureCatalogRow : public SMultiColumnTableRow<TSharedPtr<FGPACaptureCatalogEntry>>
+{
+public:
+	SLATE_BEGIN_ARGS(SGPACaptureCatalogRow) {}
+		SLATE_ARGUMENT(TSharedPtr<FGPACaptureCatalogEntry>, Entry)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs, const TSharedRef<STableViewBase>& InOwnerTable)
+	{
+		Entry = InArgs._Entry;
+		SMultiColumnTableRow<TSharedPtr<FGPACaptureCatalogEntry>>::Construct(FSuperRowType::FArguments(), InOwnerTable);
+	}
+
+	virtual TSharedRef<SWidget> GenerateWidgetForColumn(const FName& ColumnName) override
+	{
+		FText Text;
+		if (ColumnName == GPACaptureCatalogColumns::Time)
+		{
+			Text = FText::FromString(Entry->Time.ToString(TEXT("%Y-%m-%d %H:%M:%S")));
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::Map)
+		{
+			Text = FText::FromString(Entry->Map);
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::Build)
+		{
+			Text = FText::FromString(Entry->Build);
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::RHI)
+		{
+			Text = FText::FromString(Entry->RHI);
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::Frames)
+		{
+			Text = FText::AsNumber(Entry->FrameCount);
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::MeanMs)
+		{
+			Text = FText::FromString(FString::Printf(TEXT("%.2f"), Entry->MeanFrameMs));
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::MaxMs)
+		{
+			Text = FText::FromString(FString::Printf(TEXT("%.2f"), Entry->MaxFrameMs));
+		}
+		else if (ColumnName == GPACaptureCatalogColumns::Tags)
+		{
+			Text = FText::FromString(FString::Join(Entry->Tags, TEXT(", ")));
+		}
+
+		// evicted captures keep their session file, the stream itself is gone
+		return SNew(STextBlock)
+			.Text(Text)
+			.ColorAndOpacity(Entry->bEvicted ? FSlateColor::UseSubduedForeground() : FSlateColor::UseForeground())
+			.ToolTipText(Entry->bEvicted
+				? FText::Format(LOCTEXT("EvictedToolTip", "{0}, stream {1} deleted to stay within the capture disk budget"), FText::FromString(Entry->SessionFile), FText::FromString(Entry->Stream))
+				: FText::FromString(Entry->SessionFile));
+	}
+
+private:
+	TSharedPtr<FGPACaptureCatalogEntry> Entry;
+};
+
+SGPACaptureCatalog::~SGPACaptureCatalog()
+{
+	if (FGPAPluginRuntimeModule* RuntimeModule = FModuleManager::GetModulePtr<FGPAPluginRuntimeModule>("GPAPluginRuntime"))
+	{
+		if (FGPACaptureCatalog* Catalog = RuntimeModule->GetCaptureCatalog())
+		{
+			Catalog->OnCatalogChanged().Remove(CatalogChangedHandle);
+		}
+	}
+}
+
+void SGPACaptureCatalog::Construct(const FArguments& InArgs)
+{
+	if (FGPACaptureCatalog* Catalog = FGPAPluginRuntimeModule::Get().GetCaptureCatalog())
+	{
+		CatalogChangedHandle = Catalog->OnCatalogChanged().AddSP(this, &SGPACaptureCatalog::Refresh);
+	}
+
+	ChildSlot
+	[
+		SNew(SVerticalBox)
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(2.0f)
+		[
+			SNew(SSearchBox)
+			.HintText(LOCTEXT("FilterHint", "Filter, e.g. map:Arena tag:nightly since:2024-06-01 minms:16"))
+			.OnTextChanged(this, &SGPACaptureCatalog::OnFilterTextChanged)
+		]
+		+ SVerticalBox::Slot()
+		.FillHeight(1.0f)
+		[
+			SAssignNew(ListView, SListView<TSharedPtr<FGPACaptureCatalogEntry>>)
+			.ListItemsSource(&VisibleEntries)
+			.SelectionMode(ESelectionMode::Single)
+			.OnGenerateRow(this, &SGPACaptureCatalog::OnGenerateRow)
+			.OnMouseButtonDoubleClick(this, &SGPACaptureCatalog::OnEntryDoubleClicked)
+			.HeaderRow
+			(
+				SNew(SHeaderRow)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::Time).DefaultLabel(LOCTEXT("TimeColumn", "Time (UTC)")).FillWidth(1.2f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::Map).DefaultLabel(LOCTEXT("MapColumn", "Map")).FillWidth(1.0f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::Build).DefaultLabel(LOCTEXT("BuildColumn", "Build")).FillWidth(1.0f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::RHI).DefaultLabel(LOCTEXT("RHIColumn", "RHI")).FillWidth(0.5f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::Frames).DefaultLabel(LOCTEXT("FramesColumn", "Frames")).FillWidth(0.5f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::MeanMs).DefaultLabel(LOCTEXT("MeanMsColumn", "Mean ms")).FillWidth(0.5f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::MaxMs).DefaultLabel(LOCTEXT("MaxMsColumn", "Max ms")).FillWidth(0.5f)
+				+ SHeaderRow::Column(GPACaptureCatalogColumns::Tags).DefaultLabel(LOCTEXT("TagsColumn", "Tags")).FillWidth(1.0f)
+			)
+		]
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(2.0f)
+		[
+			SAssignNew(SummaryText, STextBlock)
+		]
+	];
+
+	Refresh();
+}
+
+void SGPACaptureCatalog::Refresh()
+{
+	VisibleEntries.Reset();
+	int32 TotalEntries = 0;
+	if (FGPACaptureCatalog* Catalog = FGPAPluginRuntimeModule::Get().GetCaptureCatalog())
+	{
+		for (FGPACaptureCatalogEntry& Entry : Catalog->Find(FilterText))
+		{
+			VisibleEntries.Add(MakeShared<FGPACaptureCatalogEntry>(MoveTemp(Entry)));
+		}
+		TotalEntries = Catalog->Num();
+	}
+
+	SummaryText->SetText(FText::Format(LOCTEXT("Summary", "{0} of {1} captures"), FText::AsNumber(VisibleEntries.Num()), FText::AsNumber(TotalEntries)));
+	ListView->RequestListRefresh();
+}
+
+void SGPACaptureCatalog::OnFilterTextChanged(const FText& InFilterText)
+{
+	FilterText = InFilterText.ToString();
+	Refresh();
+}
+
+TSharedRef<ITableRow> SGPACaptureCatalog::OnGenerateRow(TSharedPtr<FGPACaptureCatalogEntry> Entry, const TSharedRef<STableViewBase>& OwnerTable)
+{
+	return SNew(SGPACaptureCatalogRow, OwnerTable).Entry(Entry);
+}
+
+void SGPACaptureCatalog::OnEntryDoubleClicked(TSharedPtr<FGPACaptureCatalogEntry> Entry)
+{
+	if (Entry.IsValid())
+	{
+		FPlatformProcess::ExploreFolder(*FPaths::Combine(FGPAPluginRuntimeModule::GetCaptureOutputDirectory(), Entry->SessionFile));
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
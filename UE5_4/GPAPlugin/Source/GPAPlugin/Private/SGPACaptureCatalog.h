@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+#include "Widgets/Views/SListView.h"
+#include "GPACaptureCatalog.h"
+
+/** Searchable list of the captures in the runtime module capture catalog, refreshed as captures complete**/
+class SGPACaptureCatalog : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SGPACaptureCatalog) {}
+	SLATE_END_ARGS()
+
+	virtual ~SGPACaptureCatalog();
+
+	void Construct(const FArguments& InArgs);
+
+private:
+	/** Re-runs the catalog query with the current filter**/
+	void Refresh();
+	void OnFilterTextChanged(const FText& InFilterText);
+	TSharedRef<ITableRow> OnGenerateRow(TSharedPtr<FGPACaptureCatalogEntry> Entry, const TSharedRef<STableViewBase>& OwnerTable);
+	/** Shows the session file of the capture in the file browser**/
+	void OnEntryDoubleClicked(TSharedPtr<FGPACaptureCatalogEntry> Entry);
+
+	FString FilterText;
+	TArray<TSharedPtr<FGPACaptureCatalogEntry>> VisibleEntries;
+	TSharedPtr<SListView<TSharedPtr<FGPACaptureCatalogEntry>>> ListView;
+	TSharedPtr<class STextBlock> SummaryText;
+	FDelegateHandle CatalogChangedHandle;
+};
@@ -25,20 +25,15 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
-THIRD_PARTY_INCLUDES_START
-#include <igpa-shim-loader.h>
-#include <igpa-config.h>
-THIRD_PARTY_INCLUDES_END
-
-DECLARE_LOG_CATEGORY_EXTERN(GPAPlugin, Log, All);
-
 class FToolBarBuilder;
 class FMenuBuilder;
+class FSpawnTabArgs;
+class SDockTab;
 
+/** Editor integration of the GPA capture: toolbar button, notifications and capture catalog tab, capture itself lives in GPAPluginRuntime**/
 class FGPAPluginModule : public IModuleInterface
 {
 public:
-	FGPAPluginModule() : gpa(nullptr), bAllThirdPartyLibsLoaded(false), bStreamCaptureRunning(false) {};
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
@@ -47,30 +42,17 @@ public:
 	void PluginButtonClicked();
 	
 private:
-	/** pointer to GPA interface, use GetGPAInterface to retrieve it**/
-	IGPA* gpa;
-
-	bool bAllThirdPartyLibsLoaded;
-	bool bStreamCaptureRunning;
-
-	/** Handles to the third party dlls that were set for delayed loading**/
-	TArray<void*> ThirdPartyLibraryHandles;
-
 	/** Plugin commands defined in FGPAPluginCommand**/
 	TSharedPtr<class FUICommandList> PluginCommands;
 
-	/** Loads all dlls required by the GPA API capture tool**/
-	void LoadThirdPartyLibraries();
-	/** Releases GPA related libraries**/
-	void FreeThirdPartyLibraries();
-	/** Callback for stream capture event**/
-	void CaptureStream(const TArray<FString>& Args);
+	/** Subscription to capture messages of the runtime module**/
+	FDelegateHandle CaptureNotificationHandle;
+
 	/** Function handling on screen notification**/
 	void ShowNotification(const FString& Info);
-	/** Check if Graphics Monitor is running**/
-	bool IsGraphicsMonitorProcessRunning(const FString& AppName);
-	/** Start Graphics Monitor as a new process**/
-	void StartGraphicsMonitorProcess();
 
 	void RegisterMenus();
+
+	/** Creates the GPA Captures tab listing the runtime module capture catalog**/
+	TSharedRef<SDockTab> SpawnCaptureCatalogTab(const FSpawnTabArgs& Args);
 };
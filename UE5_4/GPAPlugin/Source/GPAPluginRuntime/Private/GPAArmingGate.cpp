@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAArmingGate.h"
+#include "HAL/IConsoleManager.h"
+#include "PipelineStateCache.h"
+#include "ContentStreaming.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/LevelStreaming.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+#if WITH_EDITOR
+#include "ShaderCompiler.h"
+#endif
+
+static TAutoConsoleVariable<int32> CVarGPAArmWaitForCompilation(
+	TEXT("gpa.ArmWaitForCompilation"),
+	1,
+	TEXT("	0: capture starts on the frame it is requested.")
+	TEXT("	1: capture waits until shader compilation and PSO precaching have drained, up to gpa.ArmTimeoutSeconds."));
+
+static TAutoConsoleVariable<int32> CVarGPAArmWaitForStreaming(
+	TEXT("gpa.ArmWaitForStreaming"),
+	0,
+	TEXT("	0: capture does not wait for streaming.")
+	TEXT("	1: capture waits until World Partition and level streaming, async loading and texture streaming are done, up to gpa.ArmTimeoutSeconds."));
+
+static TAutoConsoleVariable<float> CVarGPAArmTimeoutSeconds(
+	TEXT("gpa.ArmTimeoutSeconds"),
+	30.0f,
+	TEXT("Maximum time in seconds a capture waits for rendering to settle before it starts anyway."));
+
+FString FGPAArmingGate::GetPendingWork()
+{
+	FString PendingWork;
+	if (CVarGPAArmWaitForCompilation.GetValueOnGameThread() != 0)
+	{
+		int32 NumShaderJobs = 0;
+#if WITH_EDITOR
+		// cooked builds load precompiled shaders, only the editor compiles on demand
+		NumShaderJobs = GShaderCompilingManager != nullptr ? GShaderCompilingManager->GetNumRemainingJobs() : 0;
+#endif
+		const uint32 NumPSOPrecaches = PipelineStateCache::NumActivePrecacheRequests();
+		if (NumShaderJobs > 0 || NumPSOPrecaches > 0)
+		{
+			PendingWork = FString::Printf(TEXT("%d shaders, %u PSOs compiling"), NumShaderJobs, NumPSOPrecaches);
+		}
+	}
+
+	if (CVarGPAArmWaitForStreaming.GetValueOnGameThread() != 0)
+	{
+		const FString PendingStreaming = GetPendingStreaming();
+		if (!PendingStreaming.IsEmpty())
+		{
+			PendingWork += PendingWork.IsEmpty() ? PendingStreaming : TEXT(", ") + PendingStreaming;
+		}
+	}
+	return PendingWork;
+}
+
+double FGPAArmingGate::GetTimeoutSeconds()
+{
+	return FMath::Max(CVarGPAArmTimeoutSeconds.GetValueOnGameThread(), 0.0f);
+}
+
+FString FGPAArmingGate::GetPendingStreaming()
+{
+	TArray<FString, TInlineAllocator<4>> Pending;
+
+	// game and PIE worlds only, the editor world streams for the viewport but is not what gets captured
+	bool bWorldPartitionStreaming = false;
+	int32 NumPendingLevels = 0;
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		const UWorld* World = Context.World();
+		if (World == nullptr || !World->IsGameWorld())
+		{
+			continue;
+		}
+
+		if (World->IsPartitionedWorld())
+		{
+			const UWorldPartitionSubsystem* WorldPartitionSubsystem = World->GetSubsystem<UWorldPartitionSubsystem>();
+			bWorldPartitionStreaming |= WorldPartitionSubsystem != nullptr && !WorldPartitionSubsystem->IsAllStreamingCompleted();
+		}
+
+		for (const ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+		{
+			NumPendingLevels += StreamingLevel != nullptr && StreamingLevel->IsStreamingStatePending() ? 1 : 0;
+		}
+	}
+
+	if (bWorldPartitionStreaming)
+	{
+		Pending.Add(TEXT("World Partition streaming"));
+	}
+	if (NumPendingLevels > 0)
+	{
+		Pending.Add(FString::Printf(TEXT("%d levels streaming"), NumPendingLevels));
+	}
+	if (IsAsyncLoading())
+	{
+		Pending.Add(TEXT("async loading"));
+	}
+
+	// resources whose wanted mips are not resident yet, zero once texture streaming met its budget
+	const int32 NumWantingResources = IStreamingManager::Get().GetNumWantingResources();
+	if (NumWantingResources > 0)
+	{
+		Pending.Add(FString::Printf(TEXT("%d textures streaming"), NumWantingResources));
+	}
+
+	return FString::Join(Pending, TEXT(", "));
+}
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Decides when an armed capture may trigger. Captures wait in Arming until work that distorts the
+ * first captured frames, such as shader compilation, PSO precaching and optionally streaming, has drained
+ * or the timeout expired.
+ */
+class FGPAArmingGate
+{
+public:
+	/** Describes what the capture still waits for, empty once rendering has settled. Game thread only**/
+	static FString GetPendingWork();
+	/** Seconds after which an armed capture triggers even if work is still pending**/
+	static double GetTimeoutSeconds();
+
+private:
+	/** World Partition, level, package and texture streaming still in flight**/
+	static FString GetPendingStreaming();
+};
@@ -0,0 +1,427 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPABenchmark.h"
+#include "GPAPluginRuntimeModule.h"
+#include "GPATimings.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/DateTime.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/FileManager.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectGlobals.h"
+#include "RHI.h"
+
+bool FGPABenchmark::ParseCommandLine(FGPABenchmarkSettings& OutSettings)
+{
+	// -gpabenchmark=config:<name>,deferred:<0|1>,warmup:<n>,frames:<n>,csv:<path>
+	FString BenchmarkArgs;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("-gpabenchmark="), BenchmarkArgs, false))
+	{
+		return false;
+	}
+
+	OutSettings.CsvPath = GetDefaultCsvPath();
+
+	TArray<FString> Entries;
+	BenchmarkArgs.TrimQuotes().ParseIntoArray(Entries, TEXT(","));
+	for (const FString& Entry : Entries)
+	{
+		// split on the first separator only, paths may contain drive letters
+		FString Key, Value;
+		if (!Entry.Split(TEXT(":"), &Key, &Value))
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Ignoring malformed -gpabenchmark entry \"%s\", expecting key:value."), *Entry);
+			continue;
+		}
+
+		if (Key == TEXT("config"))
+		{
+			bool bFound = false;
+			for (EGPABenchmarkConfig Config : { EGPABenchmarkConfig::Disabled, EGPABenchmarkConfig::Loaded, EGPABenchmarkConfig::Initialized, EGPABenchmarkConfig::Capture })
+			{
+				if (Value.Equals(ToString(Config), ESearchCase::IgnoreCase))
+				{
+					OutSettings.Config = Config;
+					bFound = true;
+				}
+			}
+			if (!bFound)
+			{
+				UE_LOG(GPAPlugin, Warning, TEXT("Unknown -gpabenchmark config \"%s\", expecting disabled, loaded, initialized or capture."), *Value);
+			}
+		}
+		else if (Key == TEXT("deferred"))
+		{
+			OutSettings.bDeferred = Value != TEXT("0");
+		}
+		else if (Key == TEXT("warmup"))
+		{
+			LexFromString(OutSettings.WarmupFrames, *Value);
+		}
+		else if (Key == TEXT("frames"))
+		{
+			LexFromString(OutSettings.Frames, *Value);
+		}
+		else if (Key == TEXT("csv"))
+		{
+			OutSettings.CsvPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Value.TrimQuotes());
+		}
+		else
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Ignoring unknown -gpabenchmark key \"%s\"."), *Key);
+		}
+	}
+
+	OutSettings.WarmupFrames = FMath::Max(OutSettings.WarmupFrames, 0);
+	OutSettings.Frames = FMath::Max(OutSettings.Frames, 1);
+	return true;
+}
+
+const TCHAR* FGPABenchmark::ToString(EGPABenchmarkConfig Config)
+{
+	switch (Config)
+	{
+	case EGPABenchmarkConfig::Disabled:		return TEXT("disabled");
+	case EGPABenchmarkConfig::Loaded:		return TEXT("loaded");
+	case EGPABenchmarkConfig::Initialized:	return TEXT("initialized");
+	case EGPABenchmarkConfig::Capture:		return TEXT("capture");
+	}
+	return TEXT("unknown");
+}
+
+FString FGPABenchmark::GetDefaultCsvPath()
+{
+	return FPaths::Combine(FGPAPluginRuntimeModule::GetCaptureOutputDirectory(), TEXT("Benchmark.csv"));
+}
+
+FGPABenchmark::FGPABenchmark(const FGPABenchmarkSettings& InSettings, FOnStartCapture InOnStartCapture, FOnStopCapture InOnStopCapture)
+	: Settings(InSettings)
+	, OnStartCapture(InOnStartCapture)
+	, OnStopCapture(InOnStopCapture)
+	, Phase(EPhase::WaitingForWorld)
+	, PhaseFrame(0)
+	, LastFrameTime(0.0)
+	, StartYaw(0.0f)
+	, MemorySampleSum(0)
+	, MemorySampleCount(0)
+	, PeakUsedPhysical(0)
+{
+	FrameTimesMs.Reserve(Settings.Frames);
+	GPUTimesMs.Reserve(Settings.Frames);
+
+	UE_LOG(GPAPlugin, Log, TEXT("GPA benchmark: config %s, deferred %d, %d warmup and %d measured frames, results appended to %s."),
+		ToString(Settings.Config), Settings.bDeferred ? 1 : 0, Settings.WarmupFrames, Settings.Frames, *Settings.CsvPath);
+
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FGPABenchmark::OnEndFrame);
+}
+
+FGPABenchmark::~FGPABenchmark()
+{
+	if (EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+}
+
+void FGPABenchmark::Abort(const FString& Reason)
+{
+	if (Phase == EPhase::Done)
+	{
+		return;
+	}
+
+	UE_LOG(GPAPlugin, Error, TEXT("GPA benchmark %s aborted: %s"), ToString(Settings.Config), *Reason);
+	Phase = EPhase::Done;
+	RequestEngineExit(TEXT("GPA benchmark aborted"));
+}
+
+void FGPABenchmark::UpdateCamera(float Alpha)
+{
+	APlayerController* PlayerController = GEngine->GetFirstLocalPlayerController(GWorld);
+	if (PlayerController != nullptr)
+	{
+		PlayerController->SetControlRotation(FRotator(0.0f, StartYaw + 360.0f * Alpha, 0.0f));
+	}
+}
+
+void FGPABenchmark::OnEndFrame()
+{
+	const double Now = FPlatformTime::Seconds();
+	const double FrameTimeMs = (Now - LastFrameTime) * 1000.0;
+	LastFrameTime = Now;
+
+	switch (Phase)
+	{
+	case EPhase::WaitingForWorld:
+		// the path starts once the startup map is loaded and a player exists
+		if (GWorld != nullptr && GWorld->IsGameWorld() && !IsAsyncLoading() && GEngine->GetFirstLocalPlayerController(GWorld) != nullptr)
+		{
+			StartYaw = GEngine->GetFirstLocalPlayerController(GWorld)->GetControlRotation().Yaw;
+			Phase = EPhase::Warmup;
+			PhaseFrame = 0;
+		}
+		break;
+
+	case EPhase::Warmup:
+		// warm up along the measured path, so the measurement sees the same content
+		UpdateCamera(Settings.WarmupFrames > 0 ? (float)PhaseFrame / Settings.WarmupFrames : 0.0f);
+		if (++PhaseFrame >= Settings.WarmupFrames)
+		{
+			if (Settings.Config == EGPABenchmarkConfig::Capture && !OnStartCapture.Execute())
+			{
+				Abort(TEXT("capture could not be started"));
+				break;
+			}
+			Phase = EPhase::Measure;
+			PhaseFrame = 0;
+			UpdateCamera(0.0f);
+		}
+		break;
+
+	case EPhase::Measure:
+		FrameTimesMs.Add((float)FrameTimeMs);
+		GPUTimesMs.Add(FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles()));
+
+		// sampled sparsely, querying process memory is not free on every platform
+		if (PhaseFrame % 10 == 0)
+		{
+			const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+			MemorySampleSum += UsedPhysical;
+			++MemorySampleCount;
+			PeakUsedPhysical = FMath::Max(PeakUsedPhysical, UsedPhysical);
+		}
+
+		if (++PhaseFrame >= Settings.Frames)
+		{
+			if (Settings.Config == EGPABenchmarkConfig::Capture)
+			{
+				OnStopCapture.ExecuteIfBound();
+			}
+			Phase = EPhase::WaitingForCapture;
+		}
+		else
+		{
+			UpdateCamera((float)PhaseFrame / Settings.Frames);
+		}
+		break;
+
+	case EPhase::WaitingForCapture:
+		// results are written once the stream is complete, so finalization does not overlap the next run
+		if (Settings.Config != EGPABenchmarkConfig::Capture || FGPAPluginRuntimeModule::Get().GetCaptureState().GetState() == EGPACaptureState::Idle)
+		{
+			WriteResults();
+			Phase = EPhase::Done;
+			RequestEngineExit(TEXT("GPA benchmark complete"));
+		}
+		break;
+
+	case EPhase::Done:
+		break;
+	}
+}
+
+void FGPABenchmark::WriteResults()
+{
+	auto Mean = [](const TArray<float>& Values)
+	{
+		double Sum = 0.0;
+		for (float Value : Values)
+		{
+			Sum += Value;
+		}
+		return Values.Num() > 0 ? Sum / Values.Num() : 0.0;
+	};
+	auto Percentile = [](TArray<float> Values, double P)
+	{
+		if (Values.Num() == 0)
+		{
+			return 0.0f;
+		}
+		Values.Sort();
+		return Values[FMath::Clamp(FMath::CeilToInt32(P * Values.Num()) - 1, 0, Values.Num() - 1)];
+	};
+
+	// the module is loaded in every configuration, only the work done during its startup differs
+	const FGPAPluginRuntimeModule* RuntimeModule = FModuleManager::GetModulePtr<FGPAPluginRuntimeModule>("GPAPluginRuntime");
+	const uint32 HookApiMask = RuntimeModule != nullptr ? RuntimeModule->GetShimHookApiMask() : 0;
+
+	const double MB = 1024.0 * 1024.0;
+	const FString Row = FString::Printf(TEXT("%s,%s,%d,%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,0x%08x,%.1f\n"),
+		*FDateTime::UtcNow().ToIso8601(),
+		ToString(Settings.Config),
+		Settings.bDeferred ? 1 : 0,
+		GDynamicRHI != nullptr ? GDynamicRHI->GetName() : TEXT("None"),
+		GWorld != nullptr ? *GWorld->GetOutermost()->GetName() : TEXT(""),
+		FrameTimesMs.Num(),
+		Mean(FrameTimesMs),
+		Percentile(FrameTimesMs, 0.99),
+		Mean(GPUTimesMs),
+		Percentile(GPUTimesMs, 0.99),
+		MemorySampleCount > 0 ? MemorySampleSum / MemorySampleCount / MB : 0.0,
+		PeakUsedPhysical / MB,
+		HookApiMask,
+		FGPATimings::GetTotalMilliseconds(EGPATiming::Startup));
+
+	// header only for a new file, runs of all configurations append to the same CSV. A file written with other
+	// columns is kept aside rather than appended to, its rows would not line up
+	const FString Header = TEXT("timestamp,config,deferred,rhi,map,frames,frame_mean_ms,frame_p99_ms,gpu_mean_ms,gpu_p99_ms,memory_mean_mb,memory_peak_mb,hook_mask,startup_ms");
+	FString Csv;
+	TArray<FString> ExistingLines;
+	if (FFileHelper::LoadFileToStringArray(ExistingLines, *Settings.CsvPath) && ExistingLines.Num() > 0 && ExistingLines[0] != Header)
+	{
+		const FString OldCsvPath = FPaths::Combine(FPaths::GetPath(Settings.CsvPath), FPaths::GetBaseFilename(Settings.CsvPath) + FDateTime::UtcNow().ToString(TEXT("_%Y%m%d_%H%M%S.csv")));
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA benchmark results in %s have other columns, moved to %s."), *Settings.CsvPath, *OldCsvPath);
+		IFileManager::Get().Move(*OldCsvPath, *Settings.CsvPath);
+	}
+	if (!IFileManager::Get().FileExists(*Settings.CsvPath))
+	{
+		Csv = Header + TEXT("\n");
+	}
+	Csv += Row;
+
+	if (!FFileHelper::SaveStringToFile(Csv, *Settings.CsvPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(GPAPlugin, Error, TEXT("Could not write GPA benchmark results to %s."), *Settings.CsvPath);
+		return;
+	}
+	UE_LOG(GPAPlugin, Log, TEXT("GPA benchmark results: %s"), *Row.TrimEnd());
+}
+
+void FGPABenchmark::DumpOverhead(const FString& CsvPath, FOutputDevice& Ar)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *CsvPath) || Lines.Num() < 2)
+	{
+		Ar.Logf(TEXT("No GPA benchmark results in %s, run -gpabenchmark=config:disabled and the configurations to compare against it to measure plugin overhead."), *CsvPath);
+		return;
+	}
+
+	TArray<FString> Header;
+	Lines[0].ParseIntoArray(Header, TEXT(","), false);
+	const int32 ConfigColumn = Header.IndexOfByKey(TEXT("config"));
+	const int32 DeferredColumn = Header.IndexOfByKey(TEXT("deferred"));
+	const int32 RHIColumn = Header.IndexOfByKey(TEXT("rhi"));
+	const int32 MapColumn = Header.IndexOfByKey(TEXT("map"));
+	const int32 FrameMeanColumn = Header.IndexOfByKey(TEXT("frame_mean_ms"));
+	const int32 FrameP99Column = Header.IndexOfByKey(TEXT("frame_p99_ms"));
+	const int32 GPUMeanColumn = Header.IndexOfByKey(TEXT("gpu_mean_ms"));
+	const int32 MemoryMeanColumn = Header.IndexOfByKey(TEXT("memory_mean_mb"));
+	// missing in results written before the columns were added
+	const int32 HookMaskColumn = Header.IndexOfByKey(TEXT("hook_mask"));
+	const int32 StartupColumn = Header.IndexOfByKey(TEXT("startup_ms"));
+	if (ConfigColumn == INDEX_NONE || DeferredColumn == INDEX_NONE || RHIColumn == INDEX_NONE || MapColumn == INDEX_NONE ||
+		FrameMeanColumn == INDEX_NONE || FrameP99Column == INDEX_NONE || GPUMeanColumn == INDEX_NONE || MemoryMeanColumn == INDEX_NONE)
+	{
+		Ar.Logf(TEXT("%s is not a GPA benchmark result file."), *CsvPath);
+		return;
+	}
+
+	struct FRun
+	{
+		/** RHI and map, runs are only compared within a group**/
+		FString Group;
+		FString Config;
+		FString Deferred;
+		FString HookMask;
+		double FrameMeanMs = 0.0;
+		double FrameP99Ms = 0.0;
+		double GPUMeanMs = 0.0;
+		double MemoryMeanMB = 0.0;
+		double StartupMs = 0.0;
+	};
+
+	// later runs of a configuration replace earlier ones, so the comparison follows the latest build
+	TArray<FRun> Runs;
+	for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+	{
+		TArray<FString> Values;
+		Lines[LineIndex].ParseIntoArray(Values, TEXT(","), false);
+		if (Values.Num() != Header.Num())
+		{
+			continue;
+		}
+
+		FRun Run;
+		Run.Group = Values[RHIColumn] + TEXT(" ") + Values[MapColumn];
+		Run.Config = Values[ConfigColumn];
+		Run.Deferred = Values[DeferredColumn];
+		Run.HookMask = HookMaskColumn != INDEX_NONE ? Values[HookMaskColumn] : FString();
+		Run.FrameMeanMs = FCString::Atod(*Values[FrameMeanColumn]);
+		Run.FrameP99Ms = FCString::Atod(*Values[FrameP99Column]);
+		Run.GPUMeanMs = FCString::Atod(*Values[GPUMeanColumn]);
+		Run.MemoryMeanMB = FCString::Atod(*Values[MemoryMeanColumn]);
+		Run.StartupMs = StartupColumn != INDEX_NONE ? FCString::Atod(*Values[StartupColumn]) : 0.0;
+
+		// the capture layer is not set up without the plugin, disabled runs differ only in time
+		const bool bDisabled = Run.Config == ToString(EGPABenchmarkConfig::Disabled);
+		FRun* Existing = Runs.FindByPredicate([&Run, bDisabled](const FRun& Other)
+		{
+			return Other.Group == Run.Group && Other.Config == Run.Config && (bDisabled || (Other.Deferred == Run.Deferred && Other.HookMask == Run.HookMask));
+		});
+		if (Existing != nullptr)
+		{
+			*Existing = MoveTemp(Run);
+		}
+		else
+		{
+			Runs.Add(MoveTemp(Run));
+		}
+	}
+
+	Ar.Logf(TEXT("GPA plugin overhead against the latest run without it (config disabled), from %s:"), *CsvPath);
+	Ar.Logf(TEXT("  %-12s %8s %10s %18s %12s %12s %14s %12s"), TEXT("Config"), TEXT("Deferred"), TEXT("Hook mask"), TEXT("Frame mean ms"), TEXT("Frame p99"), TEXT("GPU mean"), TEXT("Memory MB"), TEXT("Startup ms"));
+	TSet<FString> Groups;
+	for (const FRun& Run : Runs)
+	{
+		Groups.Add(Run.Group);
+	}
+	for (const FString& Group : Groups)
+	{
+		Ar.Logf(TEXT(" %s"), *Group);
+		const FRun* Baseline = Runs.FindByPredicate([&Group](const FRun& Run) { return Run.Group == Group && Run.Config == ToString(EGPABenchmarkConfig::Disabled); });
+		if (Baseline == nullptr)
+		{
+			Ar.Logf(TEXT("  no disabled run to compare against, run -gpabenchmark=config:disabled on this RHI and map"));
+			continue;
+		}
+
+		Ar.Logf(TEXT("  %-12s %8s %10s %18.3f %12.3f %12.3f %14.1f %12.1f"), *Baseline->Config, TEXT("-"), TEXT("-"),
+			Baseline->FrameMeanMs, Baseline->FrameP99Ms, Baseline->GPUMeanMs, Baseline->MemoryMeanMB, Baseline->StartupMs);
+		for (const FRun& Run : Runs)
+		{
+			if (Run.Group != Group || &Run == Baseline)
+			{
+				continue;
+			}
+
+			const double FrameDeltaMs = Run.FrameMeanMs - Baseline->FrameMeanMs;
+			Ar.Logf(TEXT("  %-12s %8s %10s %+9.3f (%+5.1f%%) %+12.3f %+12.3f %+14.1f %+12.1f"), *Run.Config, *Run.Deferred, Run.HookMask.IsEmpty() ? TEXT("?") : *Run.HookMask,
+				FrameDeltaMs, Baseline->FrameMeanMs > 0.0 ? FrameDeltaMs / Baseline->FrameMeanMs * 100.0 : 0.0,
+				Run.FrameP99Ms - Baseline->FrameP99Ms, Run.GPUMeanMs - Baseline->GPUMeanMs, Run.MemoryMeanMB - Baseline->MemoryMeanMB, Run.StartupMs - Baseline->StartupMs);
+		}
+	}
+}
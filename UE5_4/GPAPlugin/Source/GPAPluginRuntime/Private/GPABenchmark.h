@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Plugin state measured by a benchmark run, each run measures one configuration**/
+enum class EGPABenchmarkConfig : uint8
+{
+	/** GPA is neither loaded nor initialized**/
+	Disabled,
+	/** GPA libraries are loaded, the shim is not initialized**/
+	Loaded,
+	/** Shim and capture layer initialized, no capture running**/
+	Initialized,
+	/** Stream capture runs for the whole measurement**/
+	Capture
+};
+
+struct FGPABenchmarkSettings
+{
+	EGPABenchmarkConfig Config = EGPABenchmarkConfig::Initialized;
+	/** Value of the capture layer "deferred" parameter**/
+	bool bDeferred = true;
+	/** Frames rendered along the camera path before measuring, lets streaming and shader compilation settle**/
+	int32 WarmupFrames = 120;
+	/** Frames measured, the camera completes one full turn over them**/
+	int32 Frames = 600;
+	/** CSV file results are appended to**/
+	FString CsvPath;
+};
+
+/**
+ * Measures frame time and memory over a fixed camera path for one plugin configuration, appends the result
+ * to a CSV and exits. Driven by -gpabenchmark=config:<disabled|loaded|initialized|capture>,deferred:<0|1>,
+ * warmup:<n>,frames:<n>,csv:<path> in -game runs; one run per configuration keeps load and initialization
+ * cost out of the other configurations. Combine with -gpamock for GPU-less runs. gpa.DumpTimings compares the
+ * results against the disabled configuration, which measures the same path without the plugin.
+ */
+class FGPABenchmark
+{
+public:
+	/** Starts the capture measured in the Capture configuration, returns false if it could not be started**/
+	DECLARE_DELEGATE_RetVal(bool, FOnStartCapture);
+	DECLARE_DELEGATE(FOnStopCapture);
+
+	/** Parses -gpabenchmark=, returns false if no benchmark was requested**/
+	static bool ParseCommandLine(FGPABenchmarkSettings& OutSettings);
+	static const TCHAR* ToString(EGPABenchmarkConfig Config);
+	/** Benchmark.csv in the capture output directory, used unless csv:<path> is given**/
+	static FString GetDefaultCsvPath();
+	/**
+	 * Prints the latest result of every configuration and hook mask in CsvPath as the difference to the latest
+	 * disabled run of the same RHI and map, i.e. the overhead over a run without the plugin.
+	 */
+	static void DumpOverhead(const FString& CsvPath, FOutputDevice& Ar);
+
+	FGPABenchmark(const FGPABenchmarkSettings& InSettings, FOnStartCapture InOnStartCapture, FOnStopCapture InOnStopCapture);
+	~FGPABenchmark();
+
+	/** Ends the run without results, e.g. when the configuration could not be set up**/
+	void Abort(const FString& Reason);
+
+private:
+	enum class EPhase : uint8
+	{
+		WaitingForWorld,
+		Warmup,
+		Measure,
+		WaitingForCapture,
+		Done
+	};
+
+	void OnEndFrame();
+	/** Turns the first local player's camera, Alpha in [0, 1] covers one full turn**/
+	void UpdateCamera(float Alpha);
+	void WriteResults();
+
+	FGPABenchmarkSettings Settings;
+	FOnStartCapture OnStartCapture;
+	FOnStopCapture OnStopCapture;
+	FDelegateHandle EndFrameHandle;
+
+	EPhase Phase;
+	int32 PhaseFrame;
+	double LastFrameTime;
+	float StartYaw;
+
+	/** Preallocated to Settings.Frames, so measuring does not allocate**/
+	TArray<float> FrameTimesMs;
+	TArray<float> GPUTimesMs;
+	uint64 MemorySampleSum;
+	int32 MemorySampleCount;
+	uint64 PeakUsedPhysical;
+};
@@ -0,0 +1,424 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPACaptureCatalog.h"
+#include "GPAPluginRuntimeModule.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Algo/Unique.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+/** Appends Index to the sorted entry list of Key, an entry is listed once even if e.g. a tag repeats**/
+static void AddToIndex(TMap<FString, TArray<int32>>& KeyIndex, const FString& Key, int32 Index)
+{
+	TArray<int32>& Indices = KeyIndex.FindOrAdd(Key);
+	if (Indices.Num() == 0 || Indices.Last() != Index)
+	{
+		Indices.Add(Index);
+	}
+}
+
+/** Appends the entry lists of every key containing Value**/
+static void CollectContaining(const TMap<FString, TArray<int32>>& KeyIndex, const FString& Value, TArray<int32>& OutIndices)
+{
+	// distinct keys are few compared to entries, e.g. one per map or build
+	for (const TPair<FString, TArray<int32>>& Pair : KeyIndex)
+	{
+		if (Pair.Key.Contains(Value))
+		{
+			OutIndices.Append(Pair.Value);
+		}
+	}
+}
+
+/** Keeps the indices of Candidates also found in Other, both sorted**/
+static void IntersectSorted(TArray<int32>& Candidates, const TArray<int32>& Other)
+{
+	TArray<int32> Result;
+	Result.Reserve(FMath::Min(Candidates.Num(), Other.Num()));
+	for (int32 A = 0, B = 0; A < Candidates.Num() && B < Other.Num();)
+	{
+		if (Candidates[A] < Other[B])
+		{
+			++A;
+		}
+		else if (Candidates[A] > Other[B])
+		{
+			++B;
+		}
+		else
+		{
+			Result.Add(Candidates[A]);
+			++A;
+			++B;
+		}
+	}
+	Candidates = MoveTemp(Result);
+}
+
+FGPACaptureCatalog::FGPACaptureCatalog(const FString& InCatalogPath)
+	: CatalogPath(InCatalogPath)
+	, bLoaded(false)
+{
+}
+
+void FGPACaptureCatalog::EnsureLoaded() const
+{
+	if (bLoaded)
+	{
+		return;
+	}
+	bLoaded = true;
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *CatalogPath))
+	{
+		return;
+	}
+
+	Entries.Reserve(Lines.Num());
+	for (const FString& Line : Lines)
+	{
+		FGPACaptureCatalogEntry Entry;
+		FString EvictedStream;
+		if (Line.IsEmpty())
+		{
+			continue;
+		}
+		else if (FromJsonLine(Line, Entry))
+		{
+			AddEntry(MoveTemp(Entry));
+		}
+		else if (FromEvictionLine(Line, EvictedStream))
+		{
+			ApplyEviction(EvictedStream);
+		}
+	}
+}
+
+void FGPACaptureCatalog::Load() const
+{
+	FScopeLock Lock(&CatalogLock);
+	EnsureLoaded();
+}
+
+void FGPACaptureCatalog::AddEntry(FGPACaptureCatalogEntry&& Entry) const
+{
+	const int32 Index = Entries.Add(MoveTemp(Entry));
+	const FGPACaptureCatalogEntry& Added = Entries[Index];
+	if (!Added.Stream.IsEmpty())
+	{
+		StreamIndex.Add(Added.Stream, Index);
+	}
+	AddToIndex(MapIndex, Added.Map, Index);
+	AddToIndex(BuildIndex, Added.Build, Index);
+	AddToIndex(RHIIndex, Added.RHI, Index);
+	AddToIndex(SourceIndex, Added.Source, Index);
+	for (const FString& Tag : Added.Tags)
+	{
+		AddToIndex(TagIndex, Tag, Index);
+	}
+	ChangelistIndex.FindOrAdd(Added.Changelist).Add(Index);
+}
+
+void FGPACaptureCatalog::ApplyEviction(const FString& Stream) const
+{
+	// streams the plugin did not capture have no entry
+	if (const int32* Index = StreamIndex.Find(Stream))
+	{
+		Entries[*Index].bEvicted = true;
+	}
+}
+
+void FGPACaptureCatalog::BroadcastChanged()
+{
+	// the catalog may be gone by the time the game thread runs this during shutdown
+	AsyncTask(ENamedThreads::GameThread, []()
+	{
+		FGPAPluginRuntimeModule* RuntimeModule = FModuleManager::GetModulePtr<FGPAPluginRuntimeModule>("GPAPluginRuntime");
+		if (RuntimeModule != nullptr && RuntimeModule->GetCaptureCatalog() != nullptr)
+		{
+			RuntimeModule->GetCaptureCatalog()->OnCatalogChanged().Broadcast();
+		}
+	});
+}
+
+void FGPACaptureCatalog::Add(const FGPACaptureCatalogEntry& Entry)
+{
+	{
+		FScopeLock Lock(&CatalogLock);
+		EnsureLoaded();
+
+		// appending keeps the update proportional to the new capture, not to the catalog size
+		if (!FFileHelper::SaveStringToFile(ToJsonLine(Entry) + TEXT("\n"), *CatalogPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Could not update GPA capture catalog %s."), *CatalogPath);
+		}
+		AddEntry(FGPACaptureCatalogEntry(Entry));
+	}
+
+	BroadcastChanged();
+}
+
+void FGPACaptureCatalog::MarkEvicted(const TArray<FString>& Streams)
+{
+	{
+		FScopeLock Lock(&CatalogLock);
+		EnsureLoaded();
+
+		// entries are never rewritten, an eviction line flags the entry of the stream on load
+		FString Lines;
+		for (const FString& Stream : Streams)
+		{
+			Lines += ToEvictionLine(Stream) + TEXT("\n");
+			ApplyEviction(Stream);
+		}
+		if (!FFileHelper::SaveStringToFile(Lines, *CatalogPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Could not update GPA capture catalog %s."), *CatalogPath);
+		}
+	}
+
+	BroadcastChanged();
+}
+
+int32 FGPACaptureCatalog::Num() const
+{
+	FScopeLock Lock(&CatalogLock);
+	EnsureLoaded();
+	return Entries.Num();
+}
+
+TArray<FGPACaptureCatalogEntry> FGPACaptureCatalog::Find(const FString& Filter, int32 MaxResults) const
+{
+	// terms are parsed once, then matched against every entry
+	struct FTerm
+	{
+		FString Key;
+		FString Value;
+	};
+	TArray<FTerm> Terms;
+	TArray<FString> Words;
+	Filter.ParseIntoArrayWS(Words);
+	for (const FString& Word : Words)
+	{
+		FTerm& Term = Terms.AddDefaulted_GetRef();
+		if (!Word.Split(TEXT(":"), &Term.Key, &Term.Value))
+		{
+			Term.Value = Word;
+		}
+	}
+
+	auto Matches = [&Terms](const FGPACaptureCatalogEntry& Entry)
+	{
+		for (const FTerm& Term : Terms)
+		{
+			bool bMatch = false;
+			if (Term.Key.IsEmpty())
+			{
+				bMatch = Entry.Map.Contains(Term.Value) || Entry.Build.Contains(Term.Value) || Entry.Source.Contains(Term.Value) ||
+					Entry.SessionFile.Contains(Term.Value) || Entry.Tags.ContainsByPredicate([&Term](const FString& Tag) { return Tag.Contains(Term.Value); });
+			}
+			else if (Term.Key == TEXT("map"))
+			{
+				bMatch = Entry.Map.Contains(Term.Value);
+			}
+			else if (Term.Key == TEXT("build"))
+			{
+				bMatch = Entry.Build.Contains(Term.Value) || LexToString(Entry.Changelist) == Term.Value;
+			}
+			else if (Term.Key == TEXT("rhi"))
+			{
+				bMatch = Entry.RHI.Equals(Term.Value, ESearchCase::IgnoreCase);
+			}
+			else if (Term.Key == TEXT("source"))
+			{
+				bMatch = Entry.Source.Contains(Term.Value);
+			}
+			else if (Term.Key == TEXT("tag"))
+			{
+				bMatch = Entry.Tags.Contains(Term.Value);
+			}
+			else if (Term.Key == TEXT("since"))
+			{
+				FDateTime Since;
+				bMatch = FDateTime::ParseIso8601(*Term.Value, Since) && Entry.Time >= Since;
+			}
+			else if (Term.Key == TEXT("minms"))
+			{
+				bMatch = Entry.MeanFrameMs >= FCString::Atof(*Term.Value);
+			}
+			else if (Term.Key == TEXT("evicted"))
+			{
+				bMatch = Entry.bEvicted == (Term.Value != TEXT("0"));
+			}
+
+			if (!bMatch)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	TArray<FGPACaptureCatalogEntry> Results;
+	FScopeLock Lock(&CatalogLock);
+	EnsureLoaded();
+
+	// keyed terms narrow the candidates through the indices, the remaining terms are only matched against those
+	TArray<int32> Candidates;
+	bool bNarrowed = false;
+	for (const FTerm& Term : Terms)
+	{
+		TArray<int32> Keyed;
+		if (Term.Key == TEXT("map"))
+		{
+			CollectContaining(MapIndex, Term.Value, Keyed);
+		}
+		else if (Term.Key == TEXT("build"))
+		{
+			CollectContaining(BuildIndex, Term.Value, Keyed);
+			if (const TArray<int32>* ChangelistIndices = Term.Value.IsNumeric() ? ChangelistIndex.Find(FCString::Atoi(*Term.Value)) : nullptr)
+			{
+				Keyed.Append(*ChangelistIndices);
+			}
+		}
+		else if (Term.Key == TEXT("rhi") || Term.Key == TEXT("tag"))
+		{
+			if (const TArray<int32>* Indices = (Term.Key == TEXT("rhi") ? RHIIndex : TagIndex).Find(Term.Value))
+			{
+				Keyed = *Indices;
+			}
+		}
+		else if (Term.Key == TEXT("source"))
+		{
+			CollectContaining(SourceIndex, Term.Value, Keyed);
+		}
+		else
+		{
+			continue;
+		}
+
+		// entries listed under several matching keys appear once
+		Keyed.Sort();
+		Keyed.SetNum(Algo::Unique(Keyed));
+		if (bNarrowed)
+		{
+			IntersectSorted(Candidates, Keyed);
+		}
+		else
+		{
+			Candidates = MoveTemp(Keyed);
+			bNarrowed = true;
+		}
+	}
+
+	const int32 NumCandidates = bNarrowed ? Candidates.Num() : Entries.Num();
+	for (int32 Candidate = NumCandidates - 1; Candidate >= 0 && Results.Num() < MaxResults; --Candidate)
+	{
+		const FGPACaptureCatalogEntry& Entry = Entries[bNarrowed ? Candidates[Candidate] : Candidate];
+		if (Matches(Entry))
+		{
+			Results.Add(Entry);
+		}
+	}
+	return Results;
+}
+
+FString FGPACaptureCatalog::ToJsonLine(const FGPACaptureCatalogEntry& Entry)
+{
+	TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+	Object->SetStringField(TEXT("session"), Entry.SessionFile);
+	Object->SetStringField(TEXT("stream"), Entry.Stream);
+	Object->SetStringField(TEXT("time"), Entry.Time.ToIso8601());
+	Object->SetStringField(TEXT("map"), Entry.Map);
+	Object->SetStringField(TEXT("build"), Entry.Build);
+	Object->SetNumberField(TEXT("changelist"), Entry.Changelist);
+	Object->SetStringField(TEXT("rhi"), Entry.RHI);
+	Object->SetStringField(TEXT("source"), Entry.Source);
+	Object->SetNumberField(TEXT("frames"), Entry.FrameCount);
+	Object->SetNumberField(TEXT("meanMs"), Entry.MeanFrameMs);
+	Object->SetNumberField(TEXT("maxMs"), Entry.MaxFrameMs);
+	TArray<TSharedPtr<FJsonValue>> Tags;
+	for (const FString& Tag : Entry.Tags)
+	{
+		Tags.Add(MakeShared<FJsonValueString>(Tag));
+	}
+	Object->SetArrayField(TEXT("tags"), Tags);
+
+	FString Line;
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Line);
+	FJsonSerializer::Serialize(Object, Writer);
+	return Line;
+}
+
+bool FGPACaptureCatalog::FromJsonLine(const FString& Line, FGPACaptureCatalogEntry& OutEntry)
+{
+	TSharedPtr<FJsonObject> Object;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Line);
+	if (!FJsonSerializer::Deserialize(Reader, Object) || !Object.IsValid() || !Object->TryGetStringField(TEXT("session"), OutEntry.SessionFile))
+	{
+		return false;
+	}
+
+	Object->TryGetStringField(TEXT("stream"), OutEntry.Stream);
+	FString Time;
+	Object->TryGetStringField(TEXT("time"), Time);
+	FDateTime::ParseIso8601(*Time, OutEntry.Time);
+	Object->TryGetStringField(TEXT("map"), OutEntry.Map);
+	Object->TryGetStringField(TEXT("build"), OutEntry.Build);
+	Object->TryGetNumberField(TEXT("changelist"), OutEntry.Changelist);
+	Object->TryGetStringField(TEXT("rhi"), OutEntry.RHI);
+	Object->TryGetStringField(TEXT("source"), OutEntry.Source);
+	Object->TryGetNumberField(TEXT("frames"), OutEntry.FrameCount);
+	double MeanFrameMs = 0.0, MaxFrameMs = 0.0;
+	Object->TryGetNumberField(TEXT("meanMs"), MeanFrameMs);
+	Object->TryGetNumberField(TEXT("maxMs"), MaxFrameMs);
+	OutEntry.MeanFrameMs = (float)MeanFrameMs;
+	OutEntry.MaxFrameMs = (float)MaxFrameMs;
+	Object->TryGetStringArrayField(TEXT("tags"), OutEntry.Tags);
+	return true;
+}
+
+FString FGPACaptureCatalog::ToEvictionLine(const FString& Stream)
+{
+	TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+	Object->SetStringField(TEXT("evicted"), Stream);
+	Object->SetStringField(TEXT("time"), FDateTime::UtcNow().ToIso8601());
+
+	FString Line;
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Line);
+	FJsonSerializer::Serialize(Object, Writer);
+	return Line;
+}
+
+bool FGPACaptureCatalog::FromEvictionLine(const FString& Line, FString& OutStream)
+{
+	TSharedPtr<FJsonObject> Object;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Line);
+	return FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid() && Object->TryGetStringField(TEXT("evicted"), OutStream) && !OutStream.IsEmpty();
+}
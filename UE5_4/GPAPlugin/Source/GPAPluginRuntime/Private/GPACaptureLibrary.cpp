@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPACaptureLibrary.h"
+#include "GPAPluginRuntimeModule.h"
+
+bool UGPACaptureLibrary::IsGPACaptureAvailable()
+{
+	return FGPAPluginRuntimeModule::Get().IsCaptureAvailable();
+}
+
+EGPACaptureState UGPACaptureLibrary::GetGPACaptureState()
+{
+	return FGPAPluginRuntimeModule::Get().GetCaptureState().GetState();
+}
+
+FGPACaptureHandle UGPACaptureLibrary::StartGPACapture(int32 FrameCount)
+{
+	FGPACaptureHandle Handle;
+	FGPAPluginRuntimeModule& RuntimeModule = FGPAPluginRuntimeModule::Get();
+	if (!RuntimeModule.IsCaptureAvailable())
+	{
+		return Handle;
+	}
+
+	FGPACaptureRequest Request = { FGPACaptureRequest::EType::Start, RuntimeModule.AllocateCaptureToken(EGPACaptureSource::Blueprint) };
+	Request.FrameCount = FMath::Max(FrameCount, 0);
+	RuntimeModule.QueueCaptureRequest(Request);
+
+	Handle.TokenId = (int32)Request.Token.Id;
+	return Handle;
+}
+
+void UGPACaptureLibrary::StopGPACapture(const FGPACaptureHandle& Handle)
+{
+	FGPAPluginRuntimeModule& RuntimeModule = FGPAPluginRuntimeModule::Get();
+	if (!RuntimeModule.IsCaptureAvailable() || Handle.TokenId == 0)
+	{
+		return;
+	}
+
+	FGPACaptureToken Token;
+	Token.Id = (uint32)Handle.TokenId;
+	Token.Source = EGPACaptureSource::Blueprint;
+	RuntimeModule.QueueCaptureRequest({ FGPACaptureRequest::EType::Stop, Token });
+}
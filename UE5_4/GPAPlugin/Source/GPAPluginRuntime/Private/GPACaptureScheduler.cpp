@@ -0,0 +1,199 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPACaptureScheduler.h"
+#include "GPAPluginRuntimeModule.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/UObjectGlobals.h"
+#include "Engine/World.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+FGPACaptureScheduler::FGPACaptureScheduler(FOnStartCapture InOnStartCapture)
+	: OnStartCapture(InOnStartCapture)
+	, NextWindow(0)
+	, MapReadyFrame(0)
+{
+}
+
+FGPACaptureScheduler::~FGPACaptureScheduler()
+{
+	Stop();
+}
+
+bool FGPACaptureScheduler::LoadSchedule(const FString& SchedulePath)
+{
+	FString ScheduleText;
+	if (!FFileHelper::LoadFileToString(ScheduleText, *SchedulePath))
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Could not read GPA capture schedule \"%s\"."), *SchedulePath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ScheduleText);
+	const TArray<TSharedPtr<FJsonValue>>* WindowValues = nullptr;
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || !Root->TryGetArrayField(TEXT("windows"), WindowValues))
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA capture schedule \"%s\" is not valid, expecting an object with a \"windows\" array."), *SchedulePath);
+		return false;
+	}
+
+	Stop();
+	CaptureWindows.Reset();
+	NextWindow = 0;
+	MapReadyFrame = 0;
+
+	for (const TSharedPtr<FJsonValue>& WindowValue : *WindowValues)
+	{
+		const TSharedPtr<FJsonObject>* WindowObject = nullptr;
+		if (!WindowValue->TryGetObject(WindowObject))
+		{
+			continue;
+		}
+
+		FCaptureWindow Window = {};
+		if (!(*WindowObject)->TryGetNumberField(TEXT("frames"), Window.FrameCount) || Window.FrameCount <= 0)
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Skipping GPA capture window %d, \"frames\" must be a positive number."), CaptureWindows.Num());
+			continue;
+		}
+
+		if ((*WindowObject)->TryGetNumberField(TEXT("frame"), Window.Value))
+		{
+			Window.Trigger = ETrigger::Frame;
+		}
+		else if ((*WindowObject)->TryGetNumberField(TEXT("time"), Window.Value))
+		{
+			Window.Trigger = ETrigger::Time;
+		}
+		else if ((*WindowObject)->TryGetStringField(TEXT("map"), Window.MapName))
+		{
+			Window.Trigger = ETrigger::MapLoaded;
+			(*WindowObject)->TryGetNumberField(TEXT("delayFrames"), Window.DelayFrames);
+		}
+		else
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Skipping GPA capture window %d, expecting a \"frame\", \"time\" or \"map\" trigger."), CaptureWindows.Num());
+			continue;
+		}
+
+		CaptureWindows.Add(Window);
+	}
+
+	if (CaptureWindows.Num() == 0)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA capture schedule \"%s\" contains no capture windows."), *SchedulePath);
+		return false;
+	}
+
+	UE_LOG(GPAPlugin, Log, TEXT("Loaded GPA capture schedule \"%s\" with %d capture windows."), *SchedulePath, CaptureWindows.Num());
+
+	// hooks stay bound only while windows are pending
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FGPACaptureScheduler::OnEndFrame);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FGPACaptureScheduler::OnPostLoadMap);
+	return true;
+}
+
+void FGPACaptureScheduler::Stop()
+{
+	if (EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+	if (PostLoadMapHandle.IsValid())
+	{
+		FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+		PostLoadMapHandle.Reset();
+	}
+}
+
+void FGPACaptureScheduler::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	if (LoadedWorld == nullptr || !CaptureWindows.IsValidIndex(NextWindow) || CaptureWindows[NextWindow].Trigger != ETrigger::MapLoaded)
+	{
+		return;
+	}
+
+	// accept both long package names and short map names, ignoring the PIE prefix
+	const FString PackageName = UWorld::RemovePIEPrefix(LoadedWorld->GetOutermost()->GetName());
+	const FCaptureWindow& Window = CaptureWindows[NextWindow];
+	if (PackageName.Equals(Window.MapName, ESearchCase::IgnoreCase) ||
+		FPackageName::GetShortName(PackageName).Equals(Window.MapName, ESearchCase::IgnoreCase))
+	{
+		MapReadyFrame = GFrameCounter + FMath::Max(Window.DelayFrames, 0);
+	}
+}
+
+void FGPACaptureScheduler::OnEndFrame()
+{
+	const FCaptureWindow& Window = CaptureWindows[NextWindow];
+
+	bool bDue = false;
+	switch (Window.Trigger)
+	{
+	case ETrigger::Frame:
+		bDue = GFrameCounter >= (uint64)Window.Value;
+		break;
+	case ETrigger::Time:
+		bDue = FPlatformTime::Seconds() - GStartTime >= Window.Value;
+		break;
+	case ETrigger::MapLoaded:
+		bDue = MapReadyFrame != 0 && GFrameCounter >= MapReadyFrame;
+		break;
+	}
+
+	if (!bDue)
+	{
+		return;
+	}
+
+	// a window that is due while another capture runs is retried on the next frame,
+	// one that cannot capture at all is skipped rather than retried and reported every frame
+	switch (OnStartCapture.Execute(Window.FrameCount))
+	{
+	case EGPACaptureStartResult::Busy:
+		return;
+	case EGPACaptureStartResult::Failed:
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA capture schedule skipped window %d of %d at frame %llu, capture could not be started."), NextWindow + 1, CaptureWindows.Num(), (uint64)GFrameCounter);
+		break;
+	case EGPACaptureStartResult::Started:
+		UE_LOG(GPAPlugin, Log, TEXT("GPA capture schedule started window %d of %d at frame %llu."), NextWindow + 1, CaptureWindows.Num(), (uint64)GFrameCounter);
+		break;
+	}
+
+	AdvanceWindow();
+}
+
+void FGPACaptureScheduler::AdvanceWindow()
+{
+	MapReadyFrame = 0;
+	if (++NextWindow >= CaptureWindows.Num())
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("GPA capture schedule complete."));
+		Stop();
+	}
+}
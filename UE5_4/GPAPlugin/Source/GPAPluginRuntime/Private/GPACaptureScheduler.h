@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GPAPluginRuntimeModule.h"
+
+class UWorld;
+
+/**
+ * Runs the capture windows listed in a schedule file without user interaction.
+ * Each window is started once its trigger (frame number, elapsed time or map load) is reached
+ * and covers a fixed number of frames. Windows run in file order, e.g.
+ *
+ *	{ "windows": [
+ *		{ "frame": 600, "frames": 60 },
+ *		{ "time": 45.0, "frames": 120 },
+ *		{ "map": "/Game/Maps/Arena", "delayFrames": 30, "frames": 60 } ] }
+ */
+class FGPACaptureScheduler
+{
+public:
+	/** Busy windows are retried on a later frame, failed ones are skipped**/
+	DECLARE_DELEGATE_RetVal_OneParam(EGPACaptureStartResult, FOnStartCapture, int32 /*FrameCount*/);
+
+	FGPACaptureScheduler(FOnStartCapture InOnStartCapture);
+	~FGPACaptureScheduler();
+
+	/** Loads capture windows from a schedule file, returns false if the file could not be parsed**/
+	bool LoadSchedule(const FString& SchedulePath);
+
+private:
+	enum class ETrigger : uint8
+	{
+		Frame,
+		Time,
+		MapLoaded
+	};
+
+	struct FCaptureWindow
+	{
+		ETrigger Trigger;
+		/** Engine frame number or seconds since launch, depending on trigger**/
+		double Value;
+		/** Package name of the map that has to be loaded for MapLoaded windows**/
+		FString MapName;
+		/** Frames to wait after the map load before capturing**/
+		int32 DelayFrames;
+		/** Number of frames captured by this window**/
+		int32 FrameCount;
+	};
+
+	void OnEndFrame();
+	void OnPostLoadMap(UWorld* LoadedWorld);
+	/** Moves on to the next window, stops once all windows ran**/
+	void AdvanceWindow();
+	void Stop();
+
+	FOnStartCapture OnStartCapture;
+	FDelegateHandle EndFrameHandle;
+	FDelegateHandle PostLoadMapHandle;
+
+	TArray<FCaptureWindow> CaptureWindows;
+	int32 NextWindow;
+	/** Engine frame at which the pending MapLoaded window becomes due, 0 until its map is loaded**/
+	uint64 MapReadyFrame;
+};
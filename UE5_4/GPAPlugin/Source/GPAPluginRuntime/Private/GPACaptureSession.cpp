@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPACaptureSession.h"
+#include "GPACaptureCatalog.h"
+#include "GPAPluginRuntimeModule.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Scalability.h"
+#include "Algo/BinarySearch.h"
+#include "RenderCore.h"
+#include "RHI.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+/** Number of slowest frames listed in the sidecar**/
+static constexpr int32 GPASlowestFrameCount = 10;
+
+static TAutoConsoleVariable<FString> CVarGPACaptureTags(
+	TEXT("gpa.CaptureTags"),
+	TEXT(""),
+	TEXT("Comma separated tags recorded with the following captures in their session file and the capture catalog, e.g. \"nightly,boss-fight\"."),
+	ECVF_Default);
+
+static const TCHAR* GetSetByName(EConsoleVariableFlags Flags)
+{
+	switch ((uint32)Flags & ECVF_SetByMask)
+	{
+	case ECVF_SetByConstructor:			return TEXT("Constructor");
+	case ECVF_SetByScalability:			return TEXT("Scalability");
+	case ECVF_SetByGameSetting:			return TEXT("GameSetting");
+	case ECVF_SetByProjectSetting:		return TEXT("ProjectSetting");
+	case ECVF_SetBySystemSettingsIni:	return TEXT("SystemSettingsIni");
+	case ECVF_SetByDeviceProfile:		return TEXT("DeviceProfile");
+	case ECVF_SetByGameOverride:		return TEXT("GameOverride");
+	case ECVF_SetByConsoleVariablesIni:	return TEXT("ConsoleVariablesIni");
+	case ECVF_SetByCommandline:			return TEXT("Commandline");
+	case ECVF_SetByCode:				return TEXT("Code");
+	case ECVF_SetByConsole:				return TEXT("Console");
+	}
+	return TEXT("Unknown");
+}
+
+FGPACaptureSession::FGPACaptureSession(const FGPACaptureToken& InToken, uint32 InHookApiMask, const TArray<TPair<FString, FString>>& InLayerParameters, int32 FrameTimingCapacity)
+	: Token(InToken)
+	, HookApiMask(InHookApiMask)
+	, LayerParameters(InLayerParameters)
+	, FirstFrame(0)
+	, LastFrame(0)
+	, FlightRecorderFrames(0)
+	, FlightRecorderArmedFrames(0)
+	, EngineChangelist(0)
+	, Frames(FrameTimingCapacity)
+{
+}
+
+void FGPACaptureSession::CaptureEnvironment()
+{
+	check(IsInGameThread());
+
+	StartTime = FDateTime::UtcNow();
+	FirstFrame = GFrameCounter;
+	RHIName = GDynamicRHI != nullptr ? GDynamicRHI->GetName() : TEXT("None");
+	MapName = GWorld != nullptr ? GWorld->GetOutermost()->GetName() : FString();
+	BuildVersion = FApp::GetBuildVersion();
+	EngineChangelist = FEngineVersion::Current().GetChangelist();
+	Tags.Reset();
+	CVarGPACaptureTags.GetValueOnGameThread().ParseIntoArray(Tags, TEXT(","));
+	for (FString& Tag : Tags)
+	{
+		Tag.TrimStartAndEndInline();
+	}
+	Tags.RemoveAll([](const FString& Tag) { return Tag.IsEmpty(); });
+
+	const Scalability::FQualityLevels QualityLevels = Scalability::GetQualityLevels();
+	ScalabilityLevels = {
+		{ TEXT("ViewDistance"), QualityLevels.ViewDistanceQuality },
+		{ TEXT("AntiAliasing"), QualityLevels.AntiAliasingQuality },
+		{ TEXT("Shadow"), QualityLevels.ShadowQuality },
+		{ TEXT("GlobalIllumination"), QualityLevels.GlobalIlluminationQuality },
+		{ TEXT("Reflection"), QualityLevels.ReflectionQuality },
+		{ TEXT("PostProcess"), QualityLevels.PostProcessQuality },
+		{ TEXT("Texture"), QualityLevels.TextureQuality },
+		{ TEXT("Effects"), QualityLevels.EffectsQuality },
+		{ TEXT("Foliage"), QualityLevels.FoliageQuality },
+		{ TEXT("Shading"), QualityLevels.ShadingQuality },
+		{ TEXT("ResolutionPercent"), FMath::RoundToInt(QualityLevels.ResolutionQuality) } };
+}
+
+void FGPACaptureSession::CaptureConsoleVariables()
+{
+	check(IsInGameThread());
+
+	// everything scalability does not explain is part of the configuration that produced the stream
+	ChangedConsoleVariables.Reset();
+	IConsoleManager::Get().ForEachConsoleObjectThatStartsWith(FConsoleObjectVisitor::CreateLambda([this](const TCHAR* Name, IConsoleObject* Object)
+	{
+		IConsoleVariable* Variable = Object->AsVariable();
+		const uint32 SetBy = (uint32)Object->GetFlags() & ECVF_SetByMask;
+		if (Variable != nullptr && SetBy > ECVF_SetByScalability)
+		{
+			ChangedConsoleVariables.Emplace(Name, Variable->GetString(), GetSetByName(Object->GetFlags()));
+		}
+	}), TEXT(""));
+}
+
+void FGPACaptureSession::AddFrame()
+{
+	// same sources as stat unit, draw counts are the RHI totals of the last frame it completed
+	FGPAFrameTiming Frame;
+	Frame.FrameNumber = GFrameCounter;
+	Frame.FrameMs = (float)(FApp::GetDeltaTime() * 1000.0);
+	Frame.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Frame.RenderThreadMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	Frame.RHIThreadMs = FPlatformTime::ToMilliseconds(GRHIThreadTime);
+	Frame.GPUMs = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+	Frame.DrawCalls = 0;
+	Frame.Primitives = 0;
+	for (uint32 GPUIndex = 0; GPUIndex < GNumExplicitGPUsForRendering; ++GPUIndex)
+	{
+		Frame.DrawCalls += (uint32)GNumDrawCallsRHI[GPUIndex];
+		Frame.Primitives += (uint32)GNumPrimitivesDrawnRHI[GPUIndex];
+	}
+	Frames.Add(Frame);
+	FrameTimeHistogram.Add(Frame.FrameMs, Frame.FrameNumber);
+}
+
+void FGPACaptureSession::End()
+{
+	EndTime = FDateTime::UtcNow();
+	LastFrame = GFrameCounter;
+}
+
+void FGPACaptureSession::EndFlightRecorderDump(int32 RingFrames, uint64 ArmedFrame)
+{
+	End();
+	FlightRecorderFrames = RingFrames;
+	FlightRecorderArmedFrames = LastFrame > ArmedFrame ? LastFrame - ArmedFrame : 0;
+	FirstFrame = LastFrame > ArmedFrame + (uint64)RingFrames ? LastFrame - (uint64)RingFrames : ArmedFrame;
+}
+
+FString FGPACaptureSession::GetFrameTimingsPath() const
+{
+	return GetSidecarPath().Replace(TEXT(".gpasession.json"), TEXT(".gpaframes"));
+}
+
+FString FGPACaptureSession::GetSidecarPath() const
+{
+	// GPA names streams itself, the sidecar is matched to its stream by capture time,
+	// milliseconds and the capture token keep back-to-back captures from sharing a name
+	const FString MapShortName = MapName.IsEmpty() ? TEXT("NoMap") : FPaths::GetBaseFilename(MapName);
+	return FPaths::Combine(FGPAPluginRuntimeModule::GetCaptureOutputDirectory(),
+		FString::Printf(TEXT("%s_%s_%u.gpasession.json"), *StartTime.ToString(TEXT("%Y%m%d_%H%M%S_%s")), *MapShortName, Token.Id));
+}
+
+FGPACaptureCatalogEntry FGPACaptureSession::MakeCatalogEntry() const
+{
+	FGPACaptureCatalogEntry Entry;
+	Entry.SessionFile = FPaths::GetCleanFilename(GetSidecarPath());
+	Entry.Stream = StreamName;
+	Entry.Time = StartTime;
+	Entry.Map = MapName.IsEmpty() ? FString() : FPaths::GetBaseFilename(MapName);
+	Entry.Build = BuildVersion;
+	Entry.Changelist = (int32)EngineChangelist;
+	Entry.RHI = RHIName;
+	Entry.Source = FGPACaptureStateMachine::ToString(Token.Source);
+	Entry.FrameCount = (int32)FrameTimeHistogram.Num();
+	Entry.MeanFrameMs = FrameTimeHistogram.GetMeanMs();
+	Entry.MaxFrameMs = FrameTimeHistogram.GetWorstMs();
+	Entry.Tags = Tags;
+	return Entry;
+}
+
+bool FGPACaptureSession::WriteSidecar() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("startTime"), StartTime.ToIso8601());
+	Root->SetStringField(TEXT("endTime"), EndTime.ToIso8601());
+	Root->SetNumberField(TEXT("firstFrame"), (double)FirstFrame);
+	Root->SetNumberField(TEXT("lastFrame"), (double)LastFrame);
+	Root->SetStringField(TEXT("stream"), StreamName);
+	Root->SetStringField(TEXT("source"), FGPACaptureStateMachine::ToString(Token.Source));
+	if (FlightRecorderFrames > 0)
+	{
+		Root->SetNumberField(TEXT("flightRecorderFrames"), FlightRecorderFrames);
+	}
+	Root->SetStringField(TEXT("rhi"), RHIName);
+	Root->SetStringField(TEXT("map"), MapName);
+	Root->SetStringField(TEXT("buildVersion"), BuildVersion);
+	Root->SetNumberField(TEXT("engineChangelist"), EngineChangelist);
+	TArray<TSharedPtr<FJsonValue>> TagValues;
+	for (const FString& Tag : Tags)
+	{
+		TagValues.Add(MakeShared<FJsonValueString>(Tag));
+	}
+	Root->SetArrayField(TEXT("tags"), TagValues);
+
+	TSharedRef<FJsonObject> Shim = MakeShared<FJsonObject>();
+	Shim->SetStringField(TEXT("hookApiMask"), FString::Printf(TEXT("0x%08x"), HookApiMask));
+	TSharedRef<FJsonObject> ShimLayerParameters = MakeShared<FJsonObject>();
+	for (const TPair<FString, FString>& Parameter : LayerParameters)
+	{
+		ShimLayerParameters->SetStringField(Parameter.Key, Parameter.Value);
+	}
+	Shim->SetObjectField(TEXT("captureLayerParameters"), ShimLayerParameters);
+	Root->SetObjectField(TEXT("shim"), Shim);
+
+	TSharedRef<FJsonObject> ScalabilityObject = MakeShared<FJsonObject>();
+	for (const TPair<FString, int32>& Level : ScalabilityLevels)
+	{
+		ScalabilityObject->SetNumberField(Level.Key, Level.Value);
+	}
+	Root->SetObjectField(TEXT("scalability"), ScalabilityObject);
+
+	TSharedRef<FJsonObject> ConsoleVariables = MakeShared<FJsonObject>();
+	for (const TTuple<FString, FString, FString>& Variable : ChangedConsoleVariables)
+	{
+		TSharedRef<FJsonObject> VariableObject = MakeShared<FJsonObject>();
+		VariableObject->SetStringField(TEXT("value"), Variable.Get<1>());
+		VariableObject->SetStringField(TEXT("setBy"), Variable.Get<2>());
+		ConsoleVariables->SetObjectField(Variable.Get<0>(), VariableObject);
+	}
+	Root->SetObjectField(TEXT("changedConsoleVariables"), ConsoleVariables);
+
+	TSharedRef<FJsonObject> FrameTimeStats = MakeShared<FJsonObject>();
+	FrameTimeStats->SetNumberField(TEXT("count"), (double)FrameTimeHistogram.Num());
+	FrameTimeStats->SetNumberField(TEXT("meanMs"), FrameTimeHistogram.GetMeanMs());
+	FrameTimeStats->SetNumberField(TEXT("p50Ms"), FrameTimeHistogram.GetPercentile(50.0f));
+	FrameTimeStats->SetNumberField(TEXT("p95Ms"), FrameTimeHistogram.GetPercentile(95.0f));
+	FrameTimeStats->SetNumberField(TEXT("p99Ms"), FrameTimeHistogram.GetPercentile(99.0f));
+	FrameTimeStats->SetNumberField(TEXT("worstMs"), FrameTimeHistogram.GetWorstMs());
+	FrameTimeStats->SetNumberField(TEXT("worstFrame"), (double)FrameTimeHistogram.GetWorstFrame());
+	Root->SetObjectField(TEXT("frameTimeStats"), FrameTimeStats);
+
+	// per-frame values live in the columnar file, the sidecar points at the slowest frames to look at first
+	TArray<int32, TInlineAllocator<GPASlowestFrameCount + 1>> Slowest;
+	for (int32 Index = 0; Index < Frames.Num(); ++Index)
+	{
+		const int32 Position = Algo::LowerBoundBy(Slowest, -Frames[Index].FrameMs, [this](int32 SlowIndex) { return -Frames[SlowIndex].FrameMs; });
+		if (Position < GPASlowestFrameCount)
+		{
+			Slowest.Insert(Index, Position);
+			Slowest.SetNum(FMath::Min(Slowest.Num(), GPASlowestFrameCount), EAllowShrinking::No);
+		}
+	}
+	TArray<TSharedPtr<FJsonValue>> SlowestFrames;
+	for (int32 Index : Slowest)
+	{
+		TSharedRef<FJsonObject> FrameObject = MakeShared<FJsonObject>();
+		FrameObject->SetNumberField(TEXT("frame"), (double)Frames[Index].FrameNumber);
+		FrameObject->SetNumberField(TEXT("frameMs"), Frames[Index].FrameMs);
+		FrameObject->SetNumberField(TEXT("gpuMs"), Frames[Index].GPUMs);
+		SlowestFrames.Add(MakeShared<FJsonValueObject>(FrameObject));
+	}
+	TSharedRef<FJsonObject> FrameTimings = MakeShared<FJsonObject>();
+	FrameTimings->SetStringField(TEXT("file"), FPaths::GetCleanFilename(GetFrameTimingsPath()));
+	FrameTimings->SetNumberField(TEXT("count"), Frames.Num());
+	FrameTimings->SetNumberField(TEXT("dropped"), (double)Frames.GetNumDropped());
+	FrameTimings->SetArrayField(TEXT("slowest"), SlowestFrames);
+	Root->SetObjectField(TEXT("frames"), FrameTimings);
+
+	const FString FrameTimingsPath = GetFrameTimingsPath();
+	if (!Frames.WriteColumns(FrameTimingsPath))
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Could not write GPA frame timings file %s."), *FrameTimingsPath);
+	}
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	if (!FJsonSerializer::Serialize(Root, Writer))
+	{
+		return false;
+	}
+
+	const FString SidecarPath = GetSidecarPath();
+	if (!FFileHelper::SaveStringToFile(Json, *SidecarPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Could not write GPA capture session file %s."), *SidecarPath);
+		return false;
+	}
+	UE_LOG(GPAPlugin, Log, TEXT("Wrote GPA capture session file %s."), *SidecarPath);
+	return true;
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GPACaptureState.h"
+#include "GPAFrameTimingRing.h"
+#include "GPAFrameTimeHistogram.h"
+
+struct FGPACaptureCatalogEntry;
+
+/**
+ * Describes one capture: when and where it ran, the configuration it ran with and the timings of its frames.
+ * Collected on the game thread while capturing and written as a JSON sidecar next to the stream on the
+ * capture worker once the capture stopped, so a stream can be identified without opening it.
+ */
+class FGPACaptureSession
+{
+public:
+	/** FrameTimingCapacity sizes the per-frame timings ring, 0 for sessions that record no frames such as flight recorder dumps**/
+	FGPACaptureSession(const FGPACaptureToken& InToken, uint32 InHookApiMask, const TArray<TPair<FString, FString>>& InLayerParameters, int32 FrameTimingCapacity);
+
+	/** Snapshots RHI, map, scalability and build info, cheap enough for the frame the capture triggers on, game thread only**/
+	void CaptureEnvironment();
+	/** Snapshots console variables changed above scalability level. Walks every console variable, so it runs
+	    once the capture stopped rather than on a captured frame, game thread only**/
+	void CaptureConsoleVariables();
+	/** Records the timings of the frame that just ended without allocating, game thread only**/
+	void AddFrame();
+	/** Marks the last captured frame, game thread only**/
+	void End();
+	/** Marks the last frame of a flight recorder dump, which holds up to RingFrames frames recorded since ArmedFrame
+	    and no frame timings, game thread only**/
+	void EndFlightRecorderDump(int32 RingFrames, uint64 ArmedFrame);
+
+	/** Frame time quantiles over every captured frame, game thread while capturing**/
+	const FGPAFrameTimeHistogram& GetFrameTimeHistogram() const { return FrameTimeHistogram; }
+
+	/** Writes the sidecar and the frame timings file to the capture output directory, can run on any thread once the session ended**/
+	bool WriteSidecar() const;
+	FString GetSidecarPath() const;
+	/** Columnar per-frame timings next to the sidecar, see FGPAFrameTimingRing**/
+	FString GetFrameTimingsPath() const;
+	/** Summary of the session for the capture catalog, can run on any thread once the session ended**/
+	FGPACaptureCatalogEntry MakeCatalogEntry() const;
+	/** Stream directory entry the capture layer wrote, empty if none was found, capture worker only**/
+	void SetStreamName(const FString& InStreamName) { StreamName = InStreamName; }
+	const FString& GetStreamName() const { return StreamName; }
+	/** Ring size of a flight recorder dump and the frames recorded since the ring was armed, 0 for other captures**/
+	int32 GetFlightRecorderFrames() const { return FlightRecorderFrames; }
+	uint64 GetFlightRecorderArmedFrames() const { return FlightRecorderArmedFrames; }
+
+private:
+	FGPACaptureToken Token;
+	uint32 HookApiMask;
+	TArray<TPair<FString, FString>> LayerParameters;
+
+	FDateTime StartTime;
+	FDateTime EndTime;
+	uint64 FirstFrame;
+	uint64 LastFrame;
+	/** Ring size of a flight recorder dump, 0 for other captures**/
+	int32 FlightRecorderFrames;
+	uint64 FlightRecorderArmedFrames;
+	FString RHIName;
+	FString StreamName;
+	FString MapName;
+	FString BuildVersion;
+	uint32 EngineChangelist;
+	/** From gpa.CaptureTags when the capture started**/
+	TArray<FString> Tags;
+	TArray<TPair<FString, int32>> ScalabilityLevels;
+	/** Console variables set above scalability level, with value and what set them**/
+	TArray<TTuple<FString, FString, FString>> ChangedConsoleVariables;
+	FGPAFrameTimingRing Frames;
+	/** Unlike the ring this covers every frame of the capture**/
+	FGPAFrameTimeHistogram FrameTimeHistogram;
+};
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPACaptureState.h"
+
+FGPACaptureStateMachine::FGPACaptureStateMachine()
+	: PackedState(Pack(EGPACaptureState::Idle, FGPACaptureToken()))
+	, NextTokenId(1)
+{
+}
+
+FGPACaptureToken FGPACaptureStateMachine::AllocateToken(EGPACaptureSource Source)
+{
+	FGPACaptureToken Token;
+	Token.Source = Source;
+	do
+	{
+		// 0 is reserved for the invalid token, skip it when the counter wraps
+		Token.Id = NextTokenId.fetch_add(1, std::memory_order_relaxed);
+	} while (Token.Id == 0);
+	return Token;
+}
+
+bool FGPACaptureStateMachine::TryArm(const FGPACaptureToken& Token)
+{
+	if (!Token.IsValid())
+	{
+		return false;
+	}
+
+	uint64 Expected = Pack(EGPACaptureState::Idle, FGPACaptureToken());
+	return PackedState.compare_exchange_strong(Expected, Pack(EGPACaptureState::Arming, Token), std::memory_order_acq_rel);
+}
+
+bool FGPACaptureStateMachine::TryBeginStop(const FGPACaptureToken& Token)
+{
+	uint64 Expected = PackedState.load(std::memory_order_acquire);
+	while (true)
+	{
+		const EGPACaptureState State = UnpackState(Expected);
+		if (UnpackOwner(Expected) != Token || (State != EGPACaptureState::Arming && State != EGPACaptureState::Capturing))
+		{
+			return false;
+		}
+
+		// retried if the render thread moved Arming -> Capturing concurrently
+		if (PackedState.compare_exchange_weak(Expected, Pack(EGPACaptureState::Stopping, Token), std::memory_order_acq_rel))
+		{
+			return true;
+		}
+	}
+}
+
+bool FGPACaptureStateMachine::TryTransition(const FGPACaptureToken& Token, EGPACaptureState From, EGPACaptureState To)
+{
+	uint64 Expected = Pack(From, Token);
+	const uint64 Desired = To == EGPACaptureState::Idle ? Pack(To, FGPACaptureToken()) : Pack(To, Token);
+	return PackedState.compare_exchange_strong(Expected, Desired, std::memory_order_acq_rel);
+}
+
+const TCHAR* FGPACaptureStateMachine::ToString(EGPACaptureState State)
+{
+	switch (State)
+	{
+	case EGPACaptureState::Idle:		return TEXT("Idle");
+	case EGPACaptureState::Arming:		return TEXT("Arming");
+	case EGPACaptureState::Capturing:	return TEXT("Capturing");
+	case EGPACaptureState::Stopping:	return TEXT("Stopping");
+	case EGPACaptureState::Finalizing:	return TEXT("Finalizing");
+	}
+	return TEXT("Unknown");
+}
+
+const TCHAR* FGPACaptureStateMachine::ToString(EGPACaptureSource Source)
+{
+	switch (Source)
+	{
+	case EGPACaptureSource::None:			return TEXT("None");
+	case EGPACaptureSource::Toolbar:		return TEXT("Toolbar");
+	case EGPACaptureSource::Console:		return TEXT("Console");
+	case EGPACaptureSource::Blueprint:		return TEXT("Blueprint");
+	case EGPACaptureSource::Code:			return TEXT("Code");
+	case EGPACaptureSource::RemoteControl:	return TEXT("Remote Control");
+	case EGPACaptureSource::HitchMonitor:	return TEXT("Hitch Monitor");
+	case EGPACaptureSource::Schedule:		return TEXT("Capture Schedule");
+	case EGPACaptureSource::CommandLine:	return TEXT("Command Line");
+	case EGPACaptureSource::FlightRecorder:	return TEXT("Flight Recorder");
+	case EGPACaptureSource::Benchmark:		return TEXT("Benchmark");
+	}
+	return TEXT("Unknown");
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPACaptureWorker.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+
+FGPACaptureWorker::FGPACaptureWorker()
+	: WakeEvent(FPlatformProcess::GetSynchEventFromPool())
+	, Thread(nullptr)
+	, bStopRequested(false)
+{
+	Thread = FRunnableThread::Create(this, TEXT("GPACaptureWorker"), 64 * 1024, TPri_BelowNormal);
+}
+
+FGPACaptureWorker::~FGPACaptureWorker()
+{
+	if (Thread != nullptr)
+	{
+		// Kill calls Stop and waits for the remaining jobs to drain
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FGPACaptureWorker::Enqueue(TUniqueFunction<void()>&& Job)
+{
+	// without a thread (e.g. single threaded platforms) run the job inline
+	if (Thread == nullptr)
+	{
+		Job();
+		return;
+	}
+
+	Jobs.Enqueue(MoveTemp(Job));
+	WakeEvent->Trigger();
+}
+
+uint32 FGPACaptureWorker::Run()
+{
+	while (true)
+	{
+		// read the stop flag before draining so jobs queued ahead of Stop still run
+		const bool bStopping = bStopRequested.load(std::memory_order_acquire);
+
+		TUniqueFunction<void()> Job;
+		while (Jobs.Dequeue(Job))
+		{
+			Job();
+		}
+
+		if (bStopping)
+		{
+			break;
+		}
+
+		WakeEvent->Wait();
+	}
+
+	return 0;
+}
+
+void FGPACaptureWorker::Stop()
+{
+	bStopRequested.store(true, std::memory_order_release);
+	WakeEvent->Trigger();
+}
@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+/**
+ * Dedicated thread for capture control work that may block, such as process queries or file I/O.
+ * Jobs are pushed through a lock-free queue, so producers on the game or render thread never wait.
+ */
+class FGPACaptureWorker : public FRunnable
+{
+public:
+	FGPACaptureWorker();
+	virtual ~FGPACaptureWorker();
+
+	/** Queues a job to run on the worker thread, can be called from any thread**/
+	void Enqueue(TUniqueFunction<void()>&& Job);
+
+	/** FRunnable implementation */
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Jobs;
+	FEvent* WakeEvent;
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopRequested;
+};
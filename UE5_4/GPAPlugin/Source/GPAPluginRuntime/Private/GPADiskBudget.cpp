@@ -0,0 +1,403 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPADiskBudget.h"
+#include "GPAPluginRuntimeModule.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<float> CVarGPACaptureDiskBudgetGB(
+	TEXT("gpa.CaptureDiskBudgetGB"),
+	0.0f,
+	TEXT("If 0 the stream directory is unbounded, otherwise the oldest unpinned streams are deleted once captures exceed this many GB."));
+
+static TAutoConsoleVariable<float> CVarGPAMinFreeDiskSpaceGB(
+	TEXT("gpa.MinFreeDiskSpaceGB"),
+	5.0f,
+	TEXT("Captures do not start, and running captures stop, when the capture output volume has less free space than this many GB."));
+
+static const TCHAR* GPAPinExtension = TEXT(".gpapin");
+
+/** Seconds between free space checks of a running capture**/
+static constexpr double GPADiskCheckIntervalSeconds = 1.0;
+/** Seconds between measurements of the running capture's stream, size limits overshoot by at most this much capture**/
+static constexpr double GPAStreamMeasureIntervalSeconds = 0.25;
+
+static uint64 GigabytesToBytes(float Gigabytes)
+{
+	return Gigabytes > 0.0f ? (uint64)((double)Gigabytes * 1024.0 * 1024.0 * 1024.0) : 0;
+}
+
+static double BytesToGigabytes(uint64 Bytes)
+{
+	return (double)Bytes / (1024.0 * 1024.0 * 1024.0);
+}
+
+FGPADiskBudget::FGPADiskBudget(const FString& InDirectory)
+	: Directory(InDirectory)
+	, UsedBytes(0)
+	, PinnedBytes(0)
+	, NextCaptureCheckTime(0.0)
+	, NextCaptureMeasureTime(0.0)
+	, CaptureBytes(0)
+	, bCaptureMeasurePending(false)
+{
+	// the volume is queried through the directory, GPA would create it on the first capture anyway
+	IFileManager::Get().MakeDirectory(*Directory, true);
+}
+
+uint64 FGPADiskBudget::GetBudgetBytes()
+{
+	return GigabytesToBytes(CVarGPACaptureDiskBudgetGB.GetValueOnAnyThread());
+}
+
+uint64 FGPADiskBudget::GetMinFreeBytes()
+{
+	return GigabytesToBytes(CVarGPAMinFreeDiskSpaceGB.GetValueOnAnyThread());
+}
+
+uint64 FGPADiskBudget::GetFreeBytes() const
+{
+	uint64 TotalBytes = 0;
+	uint64 FreeBytes = 0;
+	if (!FPlatformMisc::GetDiskTotalAndFreeSpace(Directory, TotalBytes, FreeBytes))
+	{
+		return MAX_uint64;
+	}
+	return FreeBytes;
+}
+
+bool FGPADiskBudget::IsStreamName(const FString& Name)
+{
+	// names also come from gpa.PinStream, so anything that could address a path outside the stream directory is rejected
+	return !Name.IsEmpty() && Name != TEXT(".") && Name != TEXT("..") && !Name.Contains(TEXT("/")) && !Name.Contains(TEXT("\\")) && !Name.EndsWith(GPAPinExtension);
+}
+
+uint64 FGPADiskBudget::GetStreamSize(const FString& Path, bool bDirectory)
+{
+	if (!bDirectory)
+	{
+		const int64 Size = IFileManager::Get().FileSize(*Path);
+		return Size > 0 ? (uint64)Size : 0;
+	}
+
+	uint64 Size = 0;
+	IFileManager::Get().IterateDirectoryStatRecursively(*Path, [&Size](const TCHAR*, const FFileStatData& StatData)
+	{
+		if (!StatData.bIsDirectory && StatData.FileSize > 0)
+		{
+			Size += (uint64)StatData.FileSize;
+		}
+		return true;
+	});
+	return Size;
+}
+
+void FGPADiskBudget::UpdateTotals()
+{
+	UsedBytes = 0;
+	PinnedBytes = 0;
+	for (const TPair<FString, FStream>& Stream : Streams)
+	{
+		UsedBytes += Stream.Value.Size;
+		PinnedBytes += Stream.Value.bPinned ? Stream.Value.Size : 0;
+	}
+}
+
+FString FGPADiskBudget::FindNewStream() const
+{
+	TArray<TPair<FString, FDateTime>> Entries;
+	IFileManager::Get().IterateDirectoryStat(*Directory, [&Entries](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		const FString Name = FPaths::GetCleanFilename(Path);
+		if (IsStreamName(Name))
+		{
+			Entries.Emplace(Name, StatData.ModificationTime);
+		}
+		return true;
+	});
+
+	FString NewestName;
+	FDateTime NewestTime = FDateTime::MinValue();
+	FScopeLock Lock(&StreamsLock);
+	for (const TPair<FString, FDateTime>& Entry : Entries)
+	{
+		if (!Streams.Contains(Entry.Key) && Entry.Value >= NewestTime)
+		{
+			NewestName = Entry.Key;
+			NewestTime = Entry.Value;
+		}
+	}
+	return NewestName;
+}
+
+TArray<FString> FGPADiskBudget::Update()
+{
+	// the top level listing is cheap, only new or changed streams are sized
+	TMap<FString, FFileStatData> Entries;
+	TSet<FString> PinnedNames;
+	IFileManager::Get().IterateDirectoryStat(*Directory, [&Entries, &PinnedNames](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		const FString Name = FPaths::GetCleanFilename(Path);
+		if (Name.EndsWith(GPAPinExtension))
+		{
+			PinnedNames.Add(Name.LeftChop(FCString::Strlen(GPAPinExtension)));
+		}
+		else if (IsStreamName(Name))
+		{
+			Entries.Add(Name, StatData);
+		}
+		return true;
+	});
+
+	// the game thread reads the totals every frame while capturing, so the lock is only held to copy and publish,
+	// sizing multi-GB stream directories and deleting them happens on copies. Only this worker changes the index
+	// entries, SetPinned only flips pin flags
+	TMap<FString, FStream> IndexedStreams;
+	{
+		FScopeLock Lock(&StreamsLock);
+		IndexedStreams = Streams;
+	}
+
+	TMap<FString, FStream> UpdatedStreams;
+	UpdatedStreams.Reserve(Entries.Num());
+	for (const TPair<FString, FFileStatData>& Entry : Entries)
+	{
+		FStream Stream = IndexedStreams.FindRef(Entry.Key);
+		if (Stream.TimeStamp != Entry.Value.ModificationTime || Stream.Size == 0)
+		{
+			Stream.Size = GetStreamSize(FPaths::Combine(Directory, Entry.Key), Entry.Value.bIsDirectory);
+			Stream.TimeStamp = Entry.Value.ModificationTime;
+		}
+		Stream.bPinned = PinnedNames.Contains(Entry.Key);
+		UpdatedStreams.Add(Entry.Key, Stream);
+	}
+
+	uint64 CurrentUsedBytes;
+	{
+		FScopeLock Lock(&StreamsLock);
+		Streams = UpdatedStreams;
+		UpdateTotals();
+		CurrentUsedBytes = UsedBytes;
+	}
+
+	TArray<FString> EvictedNames;
+	const uint64 BudgetBytes = GetBudgetBytes();
+	if (BudgetBytes == 0 || CurrentUsedBytes <= BudgetBytes)
+	{
+		return EvictedNames;
+	}
+
+	// least recently written first
+	TArray<FString> Candidates;
+	for (const TPair<FString, FStream>& Stream : UpdatedStreams)
+	{
+		if (!Stream.Value.bPinned)
+		{
+			Candidates.Add(Stream.Key);
+		}
+	}
+	Candidates.Sort([&UpdatedStreams](const FString& A, const FString& B) { return UpdatedStreams[A].TimeStamp < UpdatedStreams[B].TimeStamp; });
+	// the newest stream is the capture that just finished, it is kept even if it alone exceeds the budget
+	if (Candidates.Num() > 0)
+	{
+		Candidates.Pop();
+	}
+
+	uint64 EvictedBytes = 0;
+	for (const FString& Name : Candidates)
+	{
+		if (CurrentUsedBytes <= BudgetBytes)
+		{
+			break;
+		}
+
+		// a pin placed since the listing wins over eviction
+		const FString Path = FPaths::Combine(Directory, Name);
+		if (IFileManager::Get().FileExists(*(Path + GPAPinExtension)))
+		{
+			continue;
+		}
+
+		const bool bDeleted = IFileManager::Get().DirectoryExists(*Path) ? IFileManager::Get().DeleteDirectory(*Path, false, true) : IFileManager::Get().Delete(*Path, false, true);
+		if (!bDeleted)
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Could not delete GPA stream %s to stay within the capture disk budget."), *Path);
+			continue;
+		}
+
+		const uint64 Size = UpdatedStreams[Name].Size;
+		CurrentUsedBytes -= Size;
+		EvictedBytes += Size;
+		EvictedNames.Add(Name);
+		UE_LOG(GPAPlugin, Log, TEXT("Deleted GPA stream %s (%.2f GB) to stay within the capture disk budget."), *Name, BytesToGigabytes(Size));
+	}
+
+	uint64 CurrentPinnedBytes;
+	{
+		FScopeLock Lock(&StreamsLock);
+		for (const FString& Name : EvictedNames)
+		{
+			Streams.Remove(Name);
+		}
+		UpdateTotals();
+		CurrentUsedBytes = UsedBytes;
+		CurrentPinnedBytes = PinnedBytes;
+	}
+
+	if (EvictedNames.Num() > 0)
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("Deleted %d GPA streams (%.2f GB), captures now use %.2f of %.2f GB."),
+			EvictedNames.Num(), BytesToGigabytes(EvictedBytes), BytesToGigabytes(CurrentUsedBytes), BytesToGigabytes(BudgetBytes));
+	}
+	if (CurrentUsedBytes > BudgetBytes)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA captures use %.2f GB, over the %.2f GB budget, %.2f GB of it pinned."),
+			BytesToGigabytes(CurrentUsedBytes), BytesToGigabytes(BudgetBytes), BytesToGigabytes(CurrentPinnedBytes));
+	}
+	return EvictedNames;
+}
+
+bool FGPADiskBudget::CanStartCapture(FString& OutReason) const
+{
+	const uint64 FreeBytes = GetFreeBytes();
+	const uint64 MinFreeBytes = GetMinFreeBytes();
+	if (FreeBytes < MinFreeBytes)
+	{
+		OutReason = FString::Printf(TEXT("only %.2f GB free on the capture output volume, gpa.MinFreeDiskSpaceGB is %.2f GB"),
+			BytesToGigabytes(FreeBytes), BytesToGigabytes(MinFreeBytes));
+		return false;
+	}
+
+	const uint64 BudgetBytes = GetBudgetBytes();
+	if (BudgetBytes > 0 && GetPinnedBytes() >= BudgetBytes)
+	{
+		OutReason = FString::Printf(TEXT("pinned streams fill the %.2f GB capture disk budget"), BytesToGigabytes(BudgetBytes));
+		return false;
+	}
+	return true;
+}
+
+void FGPADiskBudget::BeginCapture()
+{
+	// a measurement still queued for the previous capture ran before its finalization, which precedes this start
+	CaptureBytes.store(0, std::memory_order_relaxed);
+	NextCaptureCheckTime = FPlatformTime::Seconds() + GPADiskCheckIntervalSeconds;
+	NextCaptureMeasureTime = 0.0;
+}
+
+bool FGPADiskBudget::IsCaptureMeasurementDue(bool bSizeLimited)
+{
+	const double Now = FPlatformTime::Seconds();
+	if ((!bSizeLimited && GetBudgetBytes() == 0) || Now < NextCaptureMeasureTime || bCaptureMeasurePending.exchange(true))
+	{
+		return false;
+	}
+	NextCaptureMeasureTime = Now + GPAStreamMeasureIntervalSeconds;
+	return true;
+}
+
+void FGPADiskBudget::MeasureCapture()
+{
+	// other files written to the volume meanwhile do not count against the capture
+	const FString StreamName = FindNewStream();
+	if (!StreamName.IsEmpty())
+	{
+		const FString StreamPath = FPaths::Combine(Directory, StreamName);
+		CaptureBytes.store(GetStreamSize(StreamPath, IFileManager::Get().DirectoryExists(*StreamPath)), std::memory_order_relaxed);
+	}
+	bCaptureMeasurePending.store(false);
+}
+
+bool FGPADiskBudget::ShouldStopCapture(FString& OutReason)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now < NextCaptureCheckTime)
+	{
+		return false;
+	}
+	NextCaptureCheckTime = Now + GPADiskCheckIntervalSeconds;
+
+	const uint64 FreeBytes = GetFreeBytes();
+	const uint64 MinFreeBytes = GetMinFreeBytes();
+	if (FreeBytes < MinFreeBytes)
+	{
+		OutReason = FString::Printf(TEXT("free space on the capture output volume fell below %.2f GB"), BytesToGigabytes(MinFreeBytes));
+		return true;
+	}
+
+	// eviction can make room for everything except pinned streams, a capture larger than the rest cannot be kept
+	const uint64 BudgetBytes = GetBudgetBytes();
+	if (BudgetBytes > 0 && GetCaptureBytes() + GetPinnedBytes() > BudgetBytes)
+	{
+		OutReason = FString::Printf(TEXT("the capture reached the %.2f GB capture disk budget"), BytesToGigabytes(BudgetBytes));
+		return true;
+	}
+	return false;
+}
+
+bool FGPADiskBudget::SetPinned(const FString& StreamName, bool bPinned)
+{
+	const FString StreamPath = FPaths::Combine(Directory, StreamName);
+	if (!IsStreamName(StreamName) || (!IFileManager::Get().DirectoryExists(*StreamPath) && !IFileManager::Get().FileExists(*StreamPath)))
+	{
+		return false;
+	}
+
+	const FString PinPath = StreamPath + GPAPinExtension;
+	const bool bWritten = bPinned ? FFileHelper::SaveStringToFile(FString(), *PinPath) : IFileManager::Get().Delete(*PinPath, false, true, true);
+	if (bWritten)
+	{
+		FScopeLock Lock(&StreamsLock);
+		if (FStream* Stream = Streams.Find(StreamName))
+		{
+			if (Stream->bPinned != bPinned)
+			{
+				PinnedBytes = bPinned ? PinnedBytes + Stream->Size : PinnedBytes - Stream->Size;
+				Stream->bPinned = bPinned;
+			}
+		}
+	}
+	return bWritten;
+}
+
+uint64 FGPADiskBudget::GetStreamBytes(const FString& StreamName) const
+{
+	FScopeLock Lock(&StreamsLock);
+	const FStream* Stream = Streams.Find(StreamName);
+	return Stream != nullptr ? Stream->Size : 0;
+}
+
+uint64 FGPADiskBudget::GetUsedBytes() const
+{
+	FScopeLock Lock(&StreamsLock);
+	return UsedBytes;
+}
+
+uint64 FGPADiskBudget::GetPinnedBytes() const
+{
+	FScopeLock Lock(&StreamsLock);
+	return PinnedBytes;
+}
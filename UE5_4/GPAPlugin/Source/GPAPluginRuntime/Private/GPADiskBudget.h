@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/**
+ * Keeps the stream directory within gpa.CaptureDiskBudgetGB and the output volume above gpa.MinFreeDiskSpaceGB.
+ * The capture layer writes streams to a directory of their own, so every entry in it is a stream and plugin files
+ * next to it, such as session sidecars or benchmark results, are never evicted. Streams are indexed by size once,
+ * later updates only size streams that are new or changed, and the least recently written unpinned streams are
+ * evicted when a capture pushes usage over budget. The stream of a running capture is sized on the capture worker, the
+ * game thread only reads the last measurement.
+ */
+class FGPADiskBudget
+{
+public:
+	explicit FGPADiskBudget(const FString& InDirectory);
+
+	/** Indexes new and changed streams and evicts the oldest unpinned ones until usage fits the budget, returns the
+	    names of the evicted streams. Sizing and deleting happen outside the index lock, capture worker only**/
+	TArray<FString> Update();
+	/** Newest stream that is not indexed yet, i.e. written since the last update, empty if none. Capture worker only**/
+	FString FindNewStream() const;
+
+	/** Returns false with a reason if the output volume is too full to start a capture, game thread only**/
+	bool CanStartCapture(FString& OutReason) const;
+	/** Resets the measurement of the running capture, game thread only**/
+	void BeginCapture();
+	/** Returns true with a reason if the running capture has to stop to keep the disk from filling, game thread only**/
+	bool ShouldStopCapture(FString& OutReason);
+
+	/** Returns true if the running capture's stream is due to be sized, the caller then queues MeasureCapture on the
+	    capture worker. bSizeLimited is set for captures with a size limit of their own, game thread only**/
+	bool IsCaptureMeasurementDue(bool bSizeLimited);
+	/** Sizes the stream the running capture writes, i.e. the one not indexed yet, capture worker only**/
+	void MeasureCapture();
+	/** Size of the running capture's stream at the last measurement, 0 until the stream appears**/
+	uint64 GetCaptureBytes() const { return CaptureBytes.load(std::memory_order_relaxed); }
+
+	/** Pinned streams are never evicted, the pin is a <stream>.gpapin marker file next to the stream**/
+	bool SetPinned(const FString& StreamName, bool bPinned);
+
+	/** Size of an indexed stream at the last update, 0 if it is not indexed**/
+	uint64 GetStreamBytes(const FString& StreamName) const;
+
+	/** Bytes used by indexed streams, and by the pinned ones among them**/
+	uint64 GetUsedBytes() const;
+	uint64 GetPinnedBytes() const;
+
+	static uint64 GetBudgetBytes();
+	static uint64 GetMinFreeBytes();
+
+private:
+	struct FStream
+	{
+		uint64 Size = 0;
+		/** Modification time of the stream, also its recency for eviction**/
+		FDateTime TimeStamp;
+		bool bPinned = false;
+	};
+
+	/** Free bytes on the output volume, MAX_uint64 if the platform cannot tell**/
+	uint64 GetFreeBytes() const;
+	/** Streams are the top level files and directories of the stream directory, except pin markers**/
+	static bool IsStreamName(const FString& Name);
+	static uint64 GetStreamSize(const FString& Path, bool bDirectory);
+	/** Sums stream sizes into UsedBytes and PinnedBytes, StreamsLock must be held**/
+	void UpdateTotals();
+
+	FString Directory;
+	mutable FCriticalSection StreamsLock;
+	TMap<FString, FStream> Streams;
+	uint64 UsedBytes;
+	uint64 PinnedBytes;
+
+	double NextCaptureCheckTime;
+	double NextCaptureMeasureTime;
+	/** Last measured size of the running capture's stream, written by the worker and read by the game thread**/
+	std::atomic<uint64> CaptureBytes;
+	/** Set while a measurement is queued, so a slow walk never piles up jobs on the worker**/
+	std::atomic<bool> bCaptureMeasurePending;
+};
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAFrameTimeHistogram.h"
+
+static constexpr double GPAHistogramMinMs = 0.01;
+static const double GPAHistogramLogBase = FMath::Loge(1.01);
+
+FGPAFrameTimeHistogram::FGPAFrameTimeHistogram()
+	: Buckets(InPlace, 0)
+	, Count(0)
+	, SumMs(0.0)
+	, BestMs(MAX_flt)
+	, WorstMs(0.0f)
+	, WorstFrame(0)
+{
+}
+
+int32 FGPAFrameTimeHistogram::GetBucket(float FrameMs)
+{
+	if (FrameMs <= GPAHistogramMinMs)
+	{
+		return 0;
+	}
+	return FMath::Min(FMath::FloorToInt32(FMath::Loge(FrameMs / GPAHistogramMinMs) / GPAHistogramLogBase), NumBuckets - 1);
+}
+
+float FGPAFrameTimeHistogram::GetBucketValue(int32 Bucket)
+{
+	// geometric middle of the bucket
+	return (float)(GPAHistogramMinMs * FMath::Exp((Bucket + 0.5) * GPAHistogramLogBase));
+}
+
+void FGPAFrameTimeHistogram::Add(float FrameMs, uint64 FrameNumber)
+{
+	++Buckets[GetBucket(FrameMs)];
+	++Count;
+	SumMs += FrameMs;
+	BestMs = FMath::Min(BestMs, FrameMs);
+	if (FrameMs > WorstMs)
+	{
+		WorstMs = FrameMs;
+		WorstFrame = FrameNumber;
+	}
+}
+
+float FGPAFrameTimeHistogram::GetPercentile(float Percentile) const
+{
+	if (Count == 0)
+	{
+		return 0.0f;
+	}
+
+	// nearest rank, the bucket estimate is clamped to what was actually measured
+	const uint64 Rank = FMath::Max<uint64>((uint64)FMath::CeilToDouble(FMath::Clamp(Percentile, 0.0f, 100.0f) / 100.0 * Count), 1);
+	uint64 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Buckets[Bucket];
+		if (Seen >= Rank)
+		{
+			return FMath::Clamp(GetBucketValue(Bucket), BestMs, WorstMs);
+		}
+	}
+	return WorstMs;
+}
+
+FString FGPAFrameTimeHistogram::ToString() const
+{
+	return FString::Printf(TEXT("Frame time p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, worst %.2f ms (frame %llu)."),
+		GetPercentile(50.0f), GetPercentile(95.0f), GetPercentile(99.0f), WorstMs, WorstFrame);
+}
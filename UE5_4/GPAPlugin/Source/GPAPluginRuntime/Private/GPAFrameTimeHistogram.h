@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+
+/**
+ * Streaming frame time quantiles over a capture in constant memory. Frame times are counted in logarithmic buckets
+ * 1% wide from 0.01 ms to 100 s, so any percentile is known within 1% however long the capture runs, and the mean
+ * and worst frame are exact.
+ */
+class FGPAFrameTimeHistogram
+{
+public:
+	FGPAFrameTimeHistogram();
+
+	/** Counts one frame, constant time and no allocation**/
+	void Add(float FrameMs, uint64 FrameNumber);
+
+	uint64 Num() const { return Count; }
+	/** Frame time below which Percentile percent of the frames are, 0 if empty**/
+	float GetPercentile(float Percentile) const;
+	float GetMeanMs() const { return Count > 0 ? (float)(SumMs / Count) : 0.0f; }
+	float GetWorstMs() const { return WorstMs; }
+	uint64 GetWorstFrame() const { return WorstFrame; }
+
+	/** One line summary with p50, p95, p99 and the worst frame**/
+	FString ToString() const;
+
+private:
+	/** ln(100 s / 0.01 ms) / ln(1.01), rounded up**/
+	static constexpr int32 NumBuckets = 1621;
+
+	static int32 GetBucket(float FrameMs);
+	static float GetBucketValue(int32 Bucket);
+
+	TStaticArray<uint32, NumBuckets> Buckets;
+	uint64 Count;
+	double SumMs;
+	float BestMs;
+	float WorstMs;
+	uint64 WorstFrame;
+};
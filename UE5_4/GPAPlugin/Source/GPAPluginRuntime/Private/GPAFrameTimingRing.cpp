@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAFrameTimingRing.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Serialization/Archive.h"
+
+static TAutoConsoleVariable<int32> CVarGPAFrameTimingCapacity(
+	TEXT("gpa.FrameTimingCapacity"),
+	18000,
+	TEXT("Number of frames whose timings are kept per capture, longer captures keep the most recent ones. Allocated once as each capture starts, captures bounded by frames= or maxseconds= allocate only what they can record."));
+
+static constexpr uint32 GPAFrameTimingMagic = 'G' | ('P' << 8) | ('A' << 16) | ('F' << 24);
+static constexpr uint32 GPAFrameTimingVersion = 1;
+
+FGPAFrameTimingRing::FGPAFrameTimingRing(int32 InCapacity)
+	: Head(0)
+	, NumFrames(0)
+	, NumDropped(0)
+{
+	Frames.SetNumUninitialized(FMath::Max(InCapacity, 0));
+}
+
+int32 FGPAFrameTimingRing::GetDefaultCapacity()
+{
+	return FMath::Max(CVarGPAFrameTimingCapacity.GetValueOnAnyThread(), 1);
+}
+
+int32 FGPAFrameTimingRing::GetCapacityFor(int32 FrameCount, double MaxSeconds)
+{
+	int32 Capacity = GetDefaultCapacity();
+	if (FrameCount > 0)
+	{
+		Capacity = FMath::Min(Capacity, FrameCount);
+	}
+	if (MaxSeconds > 0.0)
+	{
+		// twice the current frame rate leaves room for the capture running faster than the frame it starts on
+		const double FrameSeconds = FMath::Max(FApp::GetDeltaTime(), 1.0 / 1000.0);
+		Capacity = FMath::Min(Capacity, (int32)FMath::Min(2.0 * MaxSeconds / FrameSeconds + 1.0, (double)MAX_int32));
+	}
+	return Capacity;
+}
+
+void FGPAFrameTimingRing::Add(const FGPAFrameTiming& Frame)
+{
+	if (Frames.Num() == 0)
+	{
+		++NumDropped;
+	}
+	else if (NumFrames < Frames.Num())
+	{
+		Frames[NumFrames++] = Frame;
+	}
+	else
+	{
+		Frames[Head] = Frame;
+		Head = (Head + 1) % Frames.Num();
+		++NumDropped;
+	}
+}
+
+bool FGPAFrameTimingRing::WriteColumns(const FString& Path) const
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path));
+	if (!Writer.IsValid())
+	{
+		return false;
+	}
+	FArchive& Ar = *Writer;
+	Ar.SetByteSwapping(!PLATFORM_LITTLE_ENDIAN);
+
+	enum class EColumnType : uint8 { UInt64, Float, UInt32 };
+	struct FColumn
+	{
+		const ANSICHAR* Name;
+		EColumnType Type;
+		SIZE_T Offset;
+	};
+	static const FColumn Columns[] = {
+		{ "frame", EColumnType::UInt64, STRUCT_OFFSET(FGPAFrameTiming, FrameNumber) },
+		{ "frameMs", EColumnType::Float, STRUCT_OFFSET(FGPAFrameTiming, FrameMs) },
+		{ "gameThreadMs", EColumnType::Float, STRUCT_OFFSET(FGPAFrameTiming, GameThreadMs) },
+		{ "renderThreadMs", EColumnType::Float, STRUCT_OFFSET(FGPAFrameTiming, RenderThreadMs) },
+		{ "rhiThreadMs", EColumnType::Float, STRUCT_OFFSET(FGPAFrameTiming, RHIThreadMs) },
+		{ "gpuMs", EColumnType::Float, STRUCT_OFFSET(FGPAFrameTiming, GPUMs) },
+		{ "drawCalls", EColumnType::UInt32, STRUCT_OFFSET(FGPAFrameTiming, DrawCalls) },
+		{ "primitives", EColumnType::UInt32, STRUCT_OFFSET(FGPAFrameTiming, Primitives) } };
+
+	uint32 Magic = GPAFrameTimingMagic;
+	uint32 Version = GPAFrameTimingVersion;
+	uint32 FrameCount = (uint32)NumFrames;
+	uint32 ColumnCount = UE_ARRAY_COUNT(Columns);
+	Ar << Magic << Version << FrameCount << ColumnCount;
+
+	for (const FColumn& Column : Columns)
+	{
+		uint8 NameLength = (uint8)FCStringAnsi::Strlen(Column.Name);
+		uint8 Type = (uint8)Column.Type;
+		Ar << NameLength;
+		Ar.Serialize((void*)Column.Name, NameLength);
+		Ar << Type;
+	}
+
+	for (const FColumn& Column : Columns)
+	{
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			uint8* Value = (uint8*)&(*this)[Index] + Column.Offset;
+			switch (Column.Type)
+			{
+			case EColumnType::UInt64:	Ar << *(uint64*)Value; break;
+			case EColumnType::Float:	Ar << *(float*)Value; break;
+			case EColumnType::UInt32:	Ar << *(uint32*)Value; break;
+			}
+		}
+	}
+
+	return Writer->Close() && !Writer->IsError();
+}
@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Engine timings and draw counts of one captured frame**/
+struct FGPAFrameTiming
+{
+	uint64 FrameNumber;
+	float FrameMs;
+	float GameThreadMs;
+	float RenderThreadMs;
+	float RHIThreadMs;
+	float GPUMs;
+	uint32 DrawCalls;
+	uint32 Primitives;
+};
+
+/**
+ * Fixed size ring of per-frame timings, allocated once when a capture starts so recording a frame never allocates.
+ * Captures longer than the capacity keep their most recent frames, a ring of capacity 0 keeps none.
+ *
+ * WriteColumns stores the frames column by column in a little-endian binary file:
+ *   uint32 magic 'GPAF', uint32 version, uint32 frame count, uint32 column count,
+ *   per column: uint8 name length, name (ASCII), uint8 type (0 uint64, 1 float32, 2 uint32),
+ *   then the values of each column in column order, oldest frame first.
+ */
+class FGPAFrameTimingRing
+{
+public:
+	explicit FGPAFrameTimingRing(int32 InCapacity);
+
+	/** Capacity from gpa.FrameTimingCapacity**/
+	static int32 GetDefaultCapacity();
+	/** Capacity for a capture stopping after FrameCount frames or MaxSeconds, whichever is set and smaller,
+	    at most the default capacity which unbounded captures use**/
+	static int32 GetCapacityFor(int32 FrameCount, double MaxSeconds);
+
+	/** Records a frame, overwriting the oldest one once full**/
+	void Add(const FGPAFrameTiming& Frame);
+
+	int32 Num() const { return NumFrames; }
+	/** Frames overwritten because the capture ran longer than the capacity**/
+	uint64 GetNumDropped() const { return NumDropped; }
+
+	/** Frame at Index counting from the oldest one held**/
+	const FGPAFrameTiming& operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < NumFrames);
+		return Frames[(Head + Index) % Frames.Num()];
+	}
+
+	/** Writes the frames as a columnar file, see class comment**/
+	bool WriteColumns(const FString& Path) const;
+
+private:
+	TArray<FGPAFrameTiming> Frames;
+	/** Index of the oldest frame**/
+	int32 Head;
+	int32 NumFrames;
+	uint64 NumDropped;
+};
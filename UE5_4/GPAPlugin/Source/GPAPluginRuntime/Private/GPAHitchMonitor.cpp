@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAHitchMonitor.h"
+#include "Misc/CoreDelegates.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+static TAutoConsoleVariable<float> CVarGPAHitchThresholdMs(
+	TEXT("gpa.HitchThresholdMs"),
+	0.0f,
+	TEXT("	0: automatic hitch-triggered capture disabled.")
+	TEXT("	N: capture starts when game thread, render thread or GPU frame time exceeds N milliseconds."));
+
+static TAutoConsoleVariable<int32> CVarGPAHitchFrames(
+	TEXT("gpa.HitchFrames"),
+	3,
+	TEXT("Number of consecutive frames above gpa.HitchThresholdMs required to trigger a capture."));
+
+static TAutoConsoleVariable<float> CVarGPAHitchCooldownSeconds(
+	TEXT("gpa.HitchCooldownSeconds"),
+	60.0f,
+	TEXT("Minimum time in seconds between two hitch-triggered captures."));
+
+static TAutoConsoleVariable<int32> CVarGPAHitchCaptureFrames(
+	TEXT("gpa.HitchCaptureFrames"),
+	60,
+	TEXT("Number of frames captured when a hitch is detected."));
+
+int32 FGPAHitchMonitor::GetCaptureFrameCount()
+{
+	return FMath::Max(CVarGPAHitchCaptureFrames.GetValueOnAnyThread(), 1);
+}
+
+FGPAHitchMonitor::FGPAHitchMonitor(FOnHitchDetected InOnHitchDetected)
+	: OnHitchDetected(InOnHitchDetected)
+	, ThresholdCycles(0)
+	, RequiredFrames(1)
+	, ConsecutiveFrames(0)
+	, CooldownSeconds(0.0)
+	, LastHitchTime(-DBL_MAX)
+{
+	ApplySettings();
+	SettingsSinkHandle = IConsoleManager::Get().RegisterConsoleVariableSink_Handle(FConsoleCommandDelegate::CreateRaw(this, &FGPAHitchMonitor::ApplySettings));
+}
+
+FGPAHitchMonitor::~FGPAHitchMonitor()
+{
+	IConsoleManager::Get().UnregisterConsoleVariableSink_Handle(SettingsSinkHandle);
+
+	if (EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+}
+
+void FGPAHitchMonitor::ApplySettings()
+{
+	const float ThresholdMs = CVarGPAHitchThresholdMs.GetValueOnGameThread();
+	ThresholdCycles = ThresholdMs > 0.0f ? (uint32)FMath::Min(ThresholdMs / (FPlatformTime::GetSecondsPerCycle() * 1000.0), (double)MAX_uint32) : 0;
+	RequiredFrames = FMath::Max(CVarGPAHitchFrames.GetValueOnGameThread(), 1);
+	CooldownSeconds = FMath::Max(CVarGPAHitchCooldownSeconds.GetValueOnGameThread(), 0.0f);
+
+	// the hook is only bound while monitoring is enabled
+	const bool bEnabled = ThresholdCycles > 0;
+	if (bEnabled && !EndFrameHandle.IsValid())
+	{
+		ConsecutiveFrames = 0;
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FGPAHitchMonitor::OnEndFrame);
+	}
+	else if (!bEnabled && EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+}
+
+void FGPAHitchMonitor::OnEndFrame()
+{
+	// timings published by the engine for the last completed frame
+	const uint32 GPUCycles = RHIGetGPUFrameCycles();
+	if (GGameThreadTime <= ThresholdCycles && GRenderThreadTime <= ThresholdCycles && GPUCycles <= ThresholdCycles)
+	{
+		ConsecutiveFrames = 0;
+		return;
+	}
+
+	if (++ConsecutiveFrames < RequiredFrames)
+	{
+		return;
+	}
+	ConsecutiveFrames = 0;
+
+	// one capture per hitch storm
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastHitchTime < CooldownSeconds || !OnHitchDetected.IsBound())
+	{
+		return;
+	}
+
+	const FString Reason = FString::Printf(TEXT("game %.2f ms, render %.2f ms, GPU %.2f ms"),
+		FPlatformTime::ToMilliseconds(GGameThreadTime),
+		FPlatformTime::ToMilliseconds(GRenderThreadTime),
+		FPlatformTime::ToMilliseconds(GPUCycles));
+
+	// a refused trigger, e.g. while another source owns the capture, leaves the next hitch free to capture
+	if (OnHitchDetected.Execute(Reason))
+	{
+		LastHitchTime = Now;
+	}
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+
+/**
+ * Watches game thread, render thread and GPU frame times and reports a hitch
+ * once any of them stays above gpa.HitchThresholdMs for gpa.HitchFrames frames in a row.
+ * The frame-end hook is only bound while a threshold is set.
+ */
+class FGPAHitchMonitor
+{
+public:
+	/** Returns true if a capture was started or the flight recorder saved, only then the cooldown starts**/
+	DECLARE_DELEGATE_RetVal_OneParam(bool, FOnHitchDetected, const FString& /*Reason*/);
+
+	FGPAHitchMonitor(FOnHitchDetected InOnHitchDetected);
+	~FGPAHitchMonitor();
+
+	/** Number of frames a hitch-triggered capture should cover**/
+	static int32 GetCaptureFrameCount();
+
+private:
+	/** Binds or unbinds the frame-end hook to match current console variable values**/
+	void ApplySettings();
+	void OnEndFrame();
+
+	FOnHitchDetected OnHitchDetected;
+	FDelegateHandle EndFrameHandle;
+	FConsoleVariableSinkHandle SettingsSinkHandle;
+
+	/** Threshold converted to cycles once, so the per-frame check is plain integer compares**/
+	uint32 ThresholdCycles;
+	int32 RequiredFrames;
+	int32 ConsecutiveFrames;
+	double CooldownSeconds;
+	double LastHitchTime;
+};
@@ -0,0 +1,182 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPALayerParameterCheck.h"
+#include "GPAPluginRuntimeModule.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+const char* const FGPALayerParameterCheck::RingBufferFramesParameter = "ring-buffer-frames";
+const char* const FGPALayerParameterCheck::OutputDirectoryParameter = "output-dir";
+
+#if PLATFORM_WINDOWS
+static const TCHAR* GPAHelpExecutable = TEXT("gpa-help.exe");
+#else
+static const TCHAR* GPAHelpExecutable = TEXT("gpa-help");
+#endif
+/** gpa-help prints the parameters of the layer named as its argument**/
+static const TCHAR* GPAHelpArguments = TEXT("capture");
+/** gpa-help only prints, a run taking longer than this is treated as unable to tell**/
+static constexpr double GPAHelpTimeoutSeconds = 5.0;
+
+/** A dump recorded over this many times the reference frames is compared against the reference**/
+static constexpr uint64 GPARingCheckFrameRatio = 2;
+/** An unbounded capture grows about as much as the frames recorded, a bounded ring stays well below that**/
+static constexpr double GPARingCheckGrowthRatio = 1.5;
+
+FGPALayerParameterCheck::FGPALayerParameterCheck()
+	: ReferenceDumpBytes(0)
+	, ReferenceDumpFrames(0)
+	, bRingBufferChecked(false)
+	, bOutputDirectoryChecked(false)
+{
+}
+
+/** True if Output holds Parameter as a word of its own, so e.g. output-dir is not found in output-dir-mode**/
+static bool ListsParameter(const FString& Output, const FString& Parameter)
+{
+	auto IsNameChar = [](TCHAR Char) { return FChar::IsAlnum(Char) || Char == TEXT('-') || Char == TEXT('_'); };
+	for (int32 Index = Output.Find(Parameter); Index != INDEX_NONE; Index = Output.Find(Parameter, ESearchCase::CaseSensitive, ESearchDir::FromStart, Index + 1))
+	{
+		const int32 End = Index + Parameter.Len();
+		if ((Index == 0 || !IsNameChar(Output[Index - 1])) && (End == Output.Len() || !IsNameChar(Output[End])))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FGPALayerParameterCheck::QueryLayerHelp(const FString& LibraryPath)
+{
+	const FString HelpPath = FPaths::Combine(LibraryPath, GPAHelpExecutable);
+	if (!FPaths::FileExists(HelpPath))
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("No %s in %s, capture layer parameters are only checked against the captured streams."), GPAHelpExecutable, *LibraryPath);
+		return;
+	}
+
+	void* ReadPipe = nullptr;
+	void* WritePipe = nullptr;
+	FPlatformProcess::CreatePipe(ReadPipe, WritePipe);
+	FProcHandle Process = FPlatformProcess::CreateProc(*HelpPath, GPAHelpArguments, false, true, true, nullptr, 0, *LibraryPath, WritePipe, nullptr);
+
+	FString Output;
+	bool bFinished = false;
+	int32 ReturnCode = -1;
+	if (Process.IsValid())
+	{
+		// the pipe is drained while waiting so a long listing cannot block gpa-help on a full pipe
+		const double Deadline = FPlatformTime::Seconds() + GPAHelpTimeoutSeconds;
+		while (FPlatformProcess::IsProcRunning(Process) && FPlatformTime::Seconds() < Deadline)
+		{
+			Output += FPlatformProcess::ReadPipe(ReadPipe);
+			FPlatformProcess::Sleep(0.01f);
+		}
+		bFinished = !FPlatformProcess::IsProcRunning(Process);
+		if (!bFinished)
+		{
+			FPlatformProcess::TerminateProc(Process);
+		}
+		Output += FPlatformProcess::ReadPipe(ReadPipe);
+		FPlatformProcess::GetProcReturnCode(Process, &ReturnCode);
+		FPlatformProcess::CloseProc(Process);
+	}
+	FPlatformProcess::ClosePipe(ReadPipe, WritePipe);
+
+	if (!bFinished || ReturnCode != 0 || Output.TrimStartAndEnd().IsEmpty())
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("%s %s did not list the capture layer parameters, they are only checked against the captured streams."), *HelpPath, GPAHelpArguments);
+		return;
+	}
+
+	for (const char* Parameter : { RingBufferFramesParameter, OutputDirectoryParameter })
+	{
+		const FString Name = UTF8_TO_TCHAR(Parameter);
+		const bool bListed = ListsParameter(Output, Name);
+		Support.Add(Name, bListed ? EGPALayerParameterSupport::Listed : EGPALayerParameterSupport::NotListed);
+		UE_LOG(GPAPlugin, Log, TEXT("GPA capture layer parameter %s is %s by %s."), *Name, bListed ? TEXT("listed") : TEXT("not listed"), *HelpPath);
+	}
+
+	// gpa-help settles what the streams would only hint at
+	bRingBufferChecked = GetSupport(RingBufferFramesParameter) != EGPALayerParameterSupport::Unknown;
+}
+
+EGPALayerParameterSupport FGPALayerParameterCheck::GetSupport(const char* Parameter) const
+{
+	return Support.FindRef(UTF8_TO_TCHAR(Parameter));
+}
+
+bool FGPALayerParameterCheck::OnCaptureFinalized(const FString& StreamName, const FString& StreamDirectory)
+{
+	if (bOutputDirectoryChecked)
+	{
+		return false;
+	}
+
+	// one stream in place is enough, the parameter is set once for the whole session
+	bOutputDirectoryChecked = true;
+	if (!StreamName.IsEmpty())
+	{
+		return false;
+	}
+
+	// a listed parameter makes a missing stream a failed capture rather than one written elsewhere
+	if (GetSupport(OutputDirectoryParameter) == EGPALayerParameterSupport::Listed)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA capture wrote no stream to %s although gpa-help lists %s."), *StreamDirectory, UTF8_TO_TCHAR(OutputDirectoryParameter));
+		return false;
+	}
+	return true;
+}
+
+void FGPALayerParameterCheck::OnFlightRecorderDump(uint64 StreamBytes, uint64 ArmedFrames, int32 RingFrames)
+{
+	// a dump recorded over no more than the ring holds every frame either way, and an empty one says nothing
+	if (bRingBufferChecked || StreamBytes == 0 || RingFrames <= 0 || ArmedFrames <= (uint64)RingFrames)
+	{
+		return;
+	}
+
+	if (ReferenceDumpFrames == 0 || ArmedFrames < ReferenceDumpFrames)
+	{
+		ReferenceDumpBytes = StreamBytes;
+		ReferenceDumpFrames = ArmedFrames;
+		return;
+	}
+	if (ArmedFrames < ReferenceDumpFrames * GPARingCheckFrameRatio)
+	{
+		return;
+	}
+
+	bRingBufferChecked = true;
+	if ((double)StreamBytes >= (double)ReferenceDumpBytes * GPARingCheckGrowthRatio)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA flight recorder dumps grow with the time since arming (%.1f MB after %llu frames, %.1f MB after %llu frames), ")
+			TEXT("the installed capture layer may not support the ring-buffer-frames parameter and dumps hold every frame since arming. Check the capture layer parameters with gpa-help."),
+			(double)ReferenceDumpBytes / (1024.0 * 1024.0), ReferenceDumpFrames, (double)StreamBytes / (1024.0 * 1024.0), ArmedFrames);
+	}
+	else
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("GPA flight recorder dumps stay bounded, the capture layer applies ring-buffer-frames=%d."), RingFrames);
+	}
+}
@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Whether gpa-help of the GPA install lists a capture layer parameter**/
+enum class EGPALayerParameterSupport : uint8
+{
+	/** gpa-help could not be run or printed nothing, only the streams tell**/
+	Unknown,
+	Listed,
+	NotListed
+};
+
+/**
+ * IGPA::AddLayerParameter takes capture layer parameters as plain strings and the shim cannot report them back,
+ * nor does igpa-shim-loader.h list the parameters a layer understands, gpa-help prints them for an install.
+ * The plugin loads whichever GPA Framework gpa.BinaryLocation points to, so instead of pinning parameter names to one
+ * version they are looked up in the output of that install's gpa-help once at startup. Parameters gpa-help could not
+ * confirm are also checked against the streams the captures produce. Capture worker only.
+ */
+class FGPALayerParameterCheck
+{
+public:
+	/** Capture layer parameter bounding the deferred capture to a ring of the most recent frames**/
+	static const char* const RingBufferFramesParameter;
+	/** Capture layer parameter selecting the directory streams are written to**/
+	static const char* const OutputDirectoryParameter;
+
+	FGPALayerParameterCheck();
+
+	/** Runs gpa-help from LibraryPath for the capture layer and records which parameters it lists, blocks for at most a few seconds**/
+	void QueryLayerHelp(const FString& LibraryPath);
+	EGPALayerParameterSupport GetSupport(const char* Parameter) const;
+
+	/** Checks output-dir with the stream a capture left in StreamDirectory, empty if none appeared there. Returns true
+	    once the capture layer evidently ignores output-dir, i.e. the first capture left no stream and gpa-help did not list it**/
+	bool OnCaptureFinalized(const FString& StreamName, const FString& StreamDirectory);
+
+	/**
+	 * Checks ring-buffer-frames with a flight recorder dump of StreamBytes, recorded over ArmedFrames frames since
+	 * the ring was armed. A bounded ring keeps dumps at about the same size however long the recorder ran, an
+	 * ignored one makes them grow with ArmedFrames.
+	 */
+	void OnFlightRecorderDump(uint64 StreamBytes, uint64 ArmedFrames, int32 RingFrames);
+
+private:
+	/** Smallest dump recorded over more than the ring, later and longer dumps are compared against it**/
+	uint64 ReferenceDumpBytes;
+	uint64 ReferenceDumpFrames;
+	/** Set once ring-buffer-frames was confirmed or reported, no further dumps are checked**/
+	bool bRingBufferChecked;
+	/** Set once a stream appeared in the stream directory or its absence was reported**/
+	bool bOutputDirectoryChecked;
+	/** Result of QueryLayerHelp per parameter, missing ones are Unknown**/
+	TMap<FString, EGPALayerParameterSupport> Support;
+};
@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAMockShim.h"
+#include "GPALayerParameterCheck.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+
+FGPAMockShim* FGPAMockShim::Instance = nullptr;
+
+static TAutoConsoleVariable<float> CVarGPAMockTriggerLatencyMs(
+	TEXT("gpa.MockTriggerLatencyMs"),
+	0.0f,
+	TEXT("Time the mock GPA shim blocks in TriggerStreamCapture, simulating the capture toggle cost. Only used with -gpamock."));
+
+static FAutoConsoleCommandWithOutputDevice CCmdGPADumpMockCalls(
+	TEXT("gpa.DumpMockCalls"),
+	TEXT("Prints every call made to the mock GPA shim, only available with -gpamock"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FGPAMockShim* Mock = FGPAMockShim::Get();
+		if (Mock == nullptr)
+		{
+			Ar.Log(TEXT("GPA shim is not mocked, start with -gpamock."));
+			return;
+		}
+
+		const TArray<FGPAMockShim::FCall> Calls = Mock->GetCalls();
+		const double FirstCallTime = Calls.Num() > 0 ? Calls[0].Time : 0.0;
+		for (const FGPAMockShim::FCall& Call : Calls)
+		{
+			Ar.Logf(TEXT("%10.3f ms  %-20s %s"), (Call.Time - FirstCallTime) * 1000.0, FGPAMockShim::ToString(Call.Call), *Call.Arguments);
+		}
+	})
+);
+
+FGPAMockShim::FGPAMockShim(IGPA::Result InInitializeResult)
+	: InitializeResult(InInitializeResult)
+	, bCapturing(false)
+	, NumStreams(0)
+{
+	check(Instance == nullptr);
+	Instance = this;
+}
+
+void FGPAMockShim::SetHookApiMask(gpa::utility::HookApiFlags Mask)
+{
+	RecordCall(ECall::SetHookApiMask, FString::Printf(TEXT("0x%08x"), Mask));
+}
+
+void FGPAMockShim::AddLayer(char const* LayerName)
+{
+	RecordCall(ECall::AddLayer, UTF8_TO_TCHAR(LayerName));
+}
+
+void FGPAMockShim::AddLayerParameter(char const* LayerName, char const* ParameterKey, char const* ParameterValue)
+{
+	RecordCall(ECall::AddLayerParameter, FString::Printf(TEXT("%s %s=%s"), UTF8_TO_TCHAR(LayerName), UTF8_TO_TCHAR(ParameterKey), UTF8_TO_TCHAR(ParameterValue)));
+
+	if (FCStringAnsi::Strcmp(LayerName, "capture") == 0 && FCStringAnsi::Strcmp(ParameterKey, FGPALayerParameterCheck::OutputDirectoryParameter) == 0)
+	{
+		OutputDirectory = UTF8_TO_TCHAR(ParameterValue);
+	}
+}
+
+IGPA::Result FGPAMockShim::Initialize()
+{
+	RecordCall(ECall::Initialize, InitializeResult == IGPA::Result::Ok ? TEXT("Ok") : TEXT("Failed"));
+	return InitializeResult;
+}
+
+void FGPAMockShim::TriggerStreamCapture()
+{
+	const float LatencyMs = CVarGPAMockTriggerLatencyMs.GetValueOnAnyThread();
+	if (LatencyMs > 0.0f)
+	{
+		FPlatformProcess::Sleep(LatencyMs / 1000.0f);
+	}
+
+	// only toggled from the render thread
+	const bool bWasCapturing = bCapturing.load();
+	if (!bWasCapturing && !OutputDirectory.IsEmpty())
+	{
+		const FString StreamPath = FPaths::Combine(OutputDirectory, FString::Printf(TEXT("mock_%s_%d"), *FDateTime::UtcNow().ToString(TEXT("%Y%m%d_%H%M%S_%s")), ++NumStreams));
+		IFileManager::Get().MakeDirectory(*StreamPath, true);
+
+		FScopeLock Lock(&CallsLock);
+		LastStreamPath = StreamPath;
+	}
+	bCapturing.store(!bWasCapturing);
+	RecordCall(ECall::TriggerStreamCapture, bWasCapturing ? TEXT("stop") : TEXT("start"));
+}
+
+void FGPAMockShim::Release()
+{
+	RecordCall(ECall::Release, FString());
+	Instance = nullptr;
+	delete this;
+}
+
+FString FGPAMockShim::GetLastStreamPath() const
+{
+	FScopeLock Lock(&CallsLock);
+	return LastStreamPath;
+}
+
+TArray<FGPAMockShim::FCall> FGPAMockShim::GetCalls() const
+{
+	FScopeLock Lock(&CallsLock);
+	return Calls;
+}
+
+void FGPAMockShim::RecordCall(ECall Call, FString&& Arguments)
+{
+	const double Time = FPlatformTime::Seconds();
+	UE_LOG(GPAPlugin, Verbose, TEXT("Mock GPA shim: %s %s"), ToString(Call), *Arguments);
+
+	FScopeLock Lock(&CallsLock);
+	Calls.Add({ Call, Time, MoveTemp(Arguments) });
+}
+
+const TCHAR* FGPAMockShim::ToString(ECall Call)
+{
+	switch (Call)
+	{
+	case ECall::SetHookApiMask: return TEXT("SetHookApiMask");
+	case ECall::AddLayer: return TEXT("AddLayer");
+	case ECall::AddLayerParameter: return TEXT("AddLayerParameter");
+	case ECall::Initialize: return TEXT("Initialize");
+	case ECall::TriggerStreamCapture: return TEXT("TriggerStreamCapture");
+	case ECall::Release: return TEXT("Release");
+	default: return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GPAPluginRuntimeModule.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/**
+ * Stand-in for the GPA shim selected with -gpamock, needs no GPA install or GPU.
+ * Every IGPA call is recorded with a timestamp and can be printed with gpa.DumpMockCalls,
+ * gpa.MockTriggerLatencyMs simulates the cost of toggling capture, -gpamockfail makes Initialize fail.
+ * Like the capture layer, starting a capture creates an empty stream directory in the output-dir layer parameter.
+ */
+class FGPAMockShim : public IGPA
+{
+public:
+	enum class ECall : uint8
+	{
+		SetHookApiMask,
+		AddLayer,
+		AddLayerParameter,
+		Initialize,
+		TriggerStreamCapture,
+		Release
+	};
+
+	struct FCall
+	{
+		ECall Call;
+		/** FPlatformTime::Seconds when the call was made**/
+		double Time;
+		FString Arguments;
+	};
+
+	explicit FGPAMockShim(IGPA::Result InInitializeResult);
+
+	/** IGPA implementation */
+	virtual void SetHookApiMask(gpa::utility::HookApiFlags Mask) override;
+	virtual void AddLayer(char const* LayerName) override;
+	virtual void AddLayerParameter(char const* LayerName, char const* ParameterKey, char const* ParameterValue) override;
+	virtual IGPA::Result Initialize() override;
+	virtual void TriggerStreamCapture() override;
+	/** Deletes the mock, the interface must not be used afterwards**/
+	virtual void Release() override;
+
+	/** Copy of the calls recorded so far, can be called from any thread**/
+	TArray<FCall> GetCalls() const;
+	/** True between two TriggerStreamCapture calls**/
+	bool IsCapturing() const { return bCapturing; }
+	/** Stream directory created by the last capture start, empty if no output-dir was set**/
+	FString GetLastStreamPath() const;
+	/** Mock currently handed out by the runtime module, nullptr if GPA is not mocked**/
+	static FGPAMockShim* Get() { return Instance; }
+
+	static const TCHAR* ToString(ECall Call);
+
+private:
+	void RecordCall(ECall Call, FString&& Arguments);
+
+	IGPA::Result InitializeResult;
+	std::atomic<bool> bCapturing;
+	/** Capture layer output-dir, set before Initialize**/
+	FString OutputDirectory;
+	FString LastStreamPath;
+	int32 NumStreams;
+	mutable FCriticalSection CallsLock;
+	TArray<FCall> Calls;
+
+	static FGPAMockShim* Instance;
+};
@@ -0,0 +1,1344 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+ 
+#include "GPAPluginRuntimeModule.h"
+#include "GPAHitchMonitor.h"
+#include "GPACaptureScheduler.h"
+#include "GPACaptureWorker.h"
+#include "GPATimings.h"
+#include "GPAProcessTracker.h"
+#include "GPARHIBackend.h"
+#include "GPAMockShim.h"
+#include "GPABenchmark.h"
+#include "GPAArmingGate.h"
+#include "GPACaptureSession.h"
+#include "GPACaptureCatalog.h"
+#include "GPADiskBudget.h"
+#include "GPALayerParameterCheck.h"
+#include "DynamicRHI.h"
+#include "Misc/ConfigUtilities.h"
+#include "Misc/CoreDelegates.h"
+#include "CoreGlobals.h"
+#include "Async/Async.h"
+#include "RenderingThread.h"
+#include "Engine/Engine.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#endif
+
+DEFINE_LOG_CATEGORY(GPAPlugin);
+
+// register console variables that are exposed and can be modifiedin the project settings
+static TAutoConsoleVariable<FString> CVarGPABinaryLocation(
+	TEXT("gpa.BinaryLocation"),
+	TEXT(""),
+	TEXT("Path that will be used to locate GPA Framework binaries."));
+
+static TAutoConsoleVariable<int32> CVarGPARunGPAAfterCapture(
+	TEXT("gpa.RunGPAAfterCapture"),
+	0,
+	TEXT("	0: GPA UI will not be run after capture is.")
+	TEXT("	1: GPA UI will automatically start after the capture is complete."));
+
+static TAutoConsoleVariable<int32> CVarGPAFrameCaptureCount(
+	TEXT("gpa.FrameCaptureCount"),
+	0,
+	TEXT("	0: stream capture runs until explicitly stopped.")
+	TEXT("	N: stream capture automatically stops after N frames."));
+
+static TAutoConsoleVariable<int32> CVarGPAFlightRecorderFrames(
+	TEXT("gpa.FlightRecorderFrames"),
+	0,
+	TEXT("	0: flight recorder disabled, stream capture is started and stopped on request.")
+	TEXT("	N: deferred capture runs continuously keeping the last N frames, written to disk by gpa.FlightRecorder dump.")
+	TEXT(" The ring is best-effort, it relies on a capture layer parameter the GPA shim cannot confirm, the log tells at startup whether gpa-help lists it."));
+
+static TAutoConsoleVariable<FString> CVarGPACaptureSchedule(
+	TEXT("gpa.CaptureSchedule"),
+	TEXT(""),
+	TEXT("Path to a capture schedule file listing capture windows run without user interaction. Overridden by -gpaschedule=<path>."));
+
+static TAutoConsoleVariable<FString> CVarGPACaptureOutputDirectory(
+	TEXT("gpa.CaptureOutputDirectory"),
+	TEXT(""),
+	TEXT("Directory GPA streams are written to, defaults to Saved/GPA in the project directory."));
+
+static TAutoConsoleVariable<int32> CVarGPAHookApiMask(
+	TEXT("gpa.HookApiMask"),
+	0,
+	TEXT("	0: hook the active RHI only, plus Win32 on Windows.")
+	TEXT("	N: gpa::utility::HookApiFlagBits mask of APIs hooked by the GPA shim, -1 hooks all APIs."));
+
+static TAutoConsoleVariable<int32> CVarGPALazyLoad(
+	TEXT("gpa.LazyLoad"),
+	0,
+	TEXT("	0: GPA libraries are loaded and the shim initialized at startup.")
+	TEXT("	1: only the GPA install location is checked at startup, loading is deferred to the first capture request. Overridden by -gpaprearm."));
+
+// order is important, the shim loader depends on the previous libraries and must stay last
+#if PLATFORM_WINDOWS
+static const TCHAR* GPAThirdPartyDlls[] = { TEXT("logger-x64.dll"), TEXT("runtime-x64.dll"), TEXT("igpa-shim-loader-x64.dll") };
+// install directory below INTEL_GPA_FRAMEWORK holding the libraries
+static const TCHAR* GPALibrarySubdirectory = TEXT("bin\\Release");
+#else
+static const TCHAR* GPAThirdPartyDlls[] = { TEXT("liblogger.so"), TEXT("libruntime.so"), TEXT("libigpa-shim-loader.so") };
+static const TCHAR* GPALibrarySubdirectory = TEXT("bin");
+#endif
+
+gpa::utility::HookApiFlags FGPAPluginRuntimeModule::GetHookApiMask()
+{
+	const int32 ConfiguredMask = CVarGPAHookApiMask.GetValueOnAnyThread();
+	if (ConfiguredMask != 0)
+	{
+		return (gpa::utility::HookApiFlags)ConfiguredMask;
+	}
+
+	// the RHI is not created yet at PostConfigInit unless loading was deferred, resolve it the same way the engine will,
+	// RHIs without a capture backend keep the shim default of hooking everything
+	const FGPARHIBackend* Backend = GDynamicRHI != nullptr ? FGPARHIBackend::FindActive() : FGPARHIBackend::FindSelected();
+	if (Backend == nullptr)
+	{
+		return gpa::utility::kHookAll;
+	}
+
+	gpa::utility::HookApiFlags Mask = Backend->HookApiMask;
+	if (PLATFORM_WINDOWS)
+	{
+		Mask |= gpa::utility::kHookWin32;
+	}
+	return Mask;
+}
+
+FString FGPAPluginRuntimeModule::GetCaptureOutputDirectory()
+{
+	const FString OutputDirectory = CVarGPACaptureOutputDirectory.GetValueOnAnyThread();
+	if (OutputDirectory.IsEmpty())
+	{
+		return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("GPA")));
+	}
+	return FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), OutputDirectory);
+}
+
+FString FGPAPluginRuntimeModule::GetStreamDirectory()
+{
+	// kept apart from plugin files, so the disk budget can treat every entry as a stream
+	return FPaths::Combine(GetCaptureOutputDirectory(), TEXT("Streams"));
+}
+
+bool FGPAPluginRuntimeModule::ParseCommandLineCapture()
+{
+	// -gpacapture=start:<frame>,count:<n>,out:<dir>
+	FString CaptureArgs;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("-gpacapture="), CaptureArgs, false))
+	{
+		return false;
+	}
+
+	int64 StartFrame = 0;
+	int32 FrameCount = CVarGPAFrameCaptureCount.GetValueOnAnyThread();
+	TArray<FString> Entries;
+	CaptureArgs.TrimQuotes().ParseIntoArray(Entries, TEXT(","));
+	for (const FString& Entry : Entries)
+	{
+		// split on the first separator only, output paths may contain drive letters
+		FString Key, Value;
+		if (!Entry.Split(TEXT(":"), &Key, &Value))
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Ignoring malformed -gpacapture entry \"%s\", expecting key:value."), *Entry);
+			continue;
+		}
+
+		if (Key == TEXT("start"))
+		{
+			LexFromString(StartFrame, *Value);
+		}
+		else if (Key == TEXT("count"))
+		{
+			LexFromString(FrameCount, *Value);
+		}
+		else if (Key == TEXT("out"))
+		{
+			CVarGPACaptureOutputDirectory.AsVariable()->Set(*Value.TrimQuotes(), ECVF_SetByCommandline);
+		}
+		else
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Ignoring unknown -gpacapture key \"%s\"."), *Key);
+		}
+	}
+
+	// the process exits once the capture is done, so it has to be bounded
+	if (FrameCount <= 0)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("-gpacapture requires a positive frame count, e.g. -gpacapture=start:300,count:60."));
+		return false;
+	}
+
+	CommandLineCaptureFrame = FMath::Max<int64>(StartFrame, 0);
+	CommandLineCaptureCount = FrameCount;
+	UE_LOG(GPAPlugin, Log, TEXT("Command line GPA capture of %d frames will start at frame %lld, output directory %s."),
+		CommandLineCaptureCount, CommandLineCaptureFrame, *GetCaptureOutputDirectory());
+	return true;
+}
+
+void FGPAPluginRuntimeModule::TickCommandLineCapture()
+{
+	if (GFrameCounter < (uint64)CommandLineCaptureFrame || CaptureState.GetState() != EGPACaptureState::Idle)
+	{
+		return;
+	}
+
+	const FGPACaptureToken Token = CaptureState.AllocateToken(EGPACaptureSource::CommandLine);
+	const EGPACaptureStartResult Result = StartStreamCapture(Token, CommandLineCaptureCount);
+	if (Result == EGPACaptureStartResult::Busy)
+	{
+		// another source armed a capture on this boundary, try again on the next one
+		return;
+	}
+
+	CommandLineCaptureFrame = INDEX_NONE;
+	if (Result == EGPACaptureStartResult::Failed)
+	{
+		// nothing will be captured, don't leave an unattended process running
+		UE_LOG(GPAPlugin, Error, TEXT("Command line GPA capture could not be started, exiting."));
+		RequestEngineExit(TEXT("GPA command line capture failed"));
+	}
+}
+
+bool FGPAPluginRuntimeModule::FindThirdPartyLibraries()
+{
+	// the mock shim needs no install
+	if (bUseMockShim)
+	{
+		return true;
+	}
+
+	LibraryPath = CVarGPABinaryLocation.GetValueOnAnyThread();
+
+	// Verify that location in ini file is correct, if not try to use path from registry entry
+	if (!FPaths::FileExists(FPaths::Combine(LibraryPath, GPAThirdPartyDlls[0])))
+	{
+#if PLATFORM_WINDOWS
+		UE_LOG(GPAPlugin, Warning, TEXT("Directory \"%s\" from ini configuration file is not a valid GPA directory. Will try using registry entry."), *LibraryPath);
+
+		// try path from registry entry
+		FString RegSubKey = TEXT("SYSTEM\\CurrentControlSet\\Control\\Session Manager\\Environment");
+		FWindowsPlatformMisc::QueryRegKey(HKEY_LOCAL_MACHINE, *RegSubKey, TEXT("INTEL_GPA_FRAMEWORK"), LibraryPath);
+#else
+		UE_LOG(GPAPlugin, Warning, TEXT("Directory \"%s\" from ini configuration file is not a valid GPA directory. Will try using INTEL_GPA_FRAMEWORK environment variable."), *LibraryPath);
+
+		// Linux installs have no registry entry, the install script exports the same variable
+		LibraryPath = FPlatformMisc::GetEnvironmentVariable(TEXT("INTEL_GPA_FRAMEWORK"));
+#endif
+		LibraryPath = FPaths::Combine(LibraryPath, GPALibrarySubdirectory);
+
+		if (!FPaths::FileExists(FPaths::Combine(LibraryPath, GPAThirdPartyDlls[0])))
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Could not find a valid Intel(R) Graphics Performance Analyzers tool location, please verify installation."));
+			LibraryPath.Reset();
+			return false;
+		}
+		else
+		{
+			UE_LOG(GPAPlugin, Log, TEXT("Found valid GPA directory: %s."), *LibraryPath);
+		}
+	}
+
+	// update console variable to the correct path
+	CVarGPABinaryLocation.AsVariable()->Set(*LibraryPath, ECVF_SetByProjectSetting);
+	return true;
+}
+
+void FGPAPluginRuntimeModule::LoadThirdPartyLibraries()
+{
+	GPA_SCOPED_TIMING(LoadLibraries);
+
+	if (bUseMockShim)
+	{
+		bAllThirdPartyLibsLoaded = true;
+		return;
+	}
+
+	for (const TCHAR* DllName : GPAThirdPartyDlls)
+	{
+		FString DllPath = FPaths::Combine(LibraryPath, DllName);
+		void* DllHandle = FPlatformProcess::GetDllHandle(*DllPath);
+		if (DllHandle == nullptr)
+		{
+			UE_LOG(GPAPlugin, Warning, TEXT("Failed to load GPA capture library %s. Install latest GPA version."), *DllPath);
+			return;
+		}
+
+		ThirdPartyLibraryHandles.Add(DllHandle);
+	}
+
+	// if we made it this far indicate all libs have loaded
+	bAllThirdPartyLibsLoaded = true;
+}
+
+bool FGPAPluginRuntimeModule::InitializeGPA()
+{
+	if (bUseMockShim)
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("Using mock GPA shim, no streams will be written."));
+		gpa = new FGPAMockShim(FParse::Param(FCommandLine::Get(), TEXT("gpamockfail")) ? IGPA::Result::Failed : IGPA::Result::Ok);
+	}
+	else
+	{
+		GPA_SCOPED_TIMING(GetInterface);
+		// resolved from the loaded shim rather than an import library, so the same path works for .dll and .so
+		PFN_GetGPAInterface GetGPAInterfaceFunc = (PFN_GetGPAInterface)FPlatformProcess::GetDllExport(ThirdPartyLibraryHandles.Last(), TEXT("GetGPAInterface"));
+		if (GetGPAInterfaceFunc != nullptr)
+		{
+			std::string Path = std::string(TCHAR_TO_UTF8(*LibraryPath));
+			gpa = GetGPAInterfaceFunc(Path);
+		}
+	}
+	if (gpa == nullptr)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Failed to get GPA shim interface from %s."), *LibraryPath);
+		return false;
+	}
+
+	// only hook the APIs this session uses, must happen before Initialize
+	const gpa::utility::HookApiFlags HookApiMask = GetHookApiMask();
+	gpa->SetHookApiMask(HookApiMask);
+	ShimHookApiMask = HookApiMask;
+	ShimLayerParameters.Reset();
+	// add deferred capture layer do GPA shim
+	gpa->AddLayer("capture");
+	AddCaptureLayerParameter("deferred", bCaptureLayerDeferred ? "true" : "false");
+	// the shim cannot confirm parameters were applied, FGPALayerParameterCheck asks gpa-help and watches the streams
+	AddCaptureLayerParameter(FGPALayerParameterCheck::OutputDirectoryParameter, TCHAR_TO_UTF8(*GetStreamDirectory()));
+	// in flight recorder mode the capture layer only keeps a bounded window of recent frames
+	const int32 FlightRecorderFrames = CVarGPAFlightRecorderFrames.GetValueOnAnyThread();
+	if (FlightRecorderFrames > 0)
+	{
+		AddCaptureLayerParameter(FGPALayerParameterCheck::RingBufferFramesParameter, TCHAR_TO_UTF8(*FString::FromInt(FlightRecorderFrames)));
+	}
+	const double InitializeStartTime = FPlatformTime::Seconds();
+	IGPA::Result InitializeResult;
+	{
+		GPA_SCOPED_TIMING(Initialize);
+		InitializeResult = gpa->Initialize();
+	}
+	if (InitializeResult != IGPA::Result::Ok)
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Failed to initialize GPA capture library!"));
+		gpa->Release();
+		gpa = nullptr;
+		return false;
+	}
+
+	// logged so startup cost of different hook masks can be compared
+	UE_LOG(GPAPlugin, Log, TEXT("GPA capture library initialized in %.2f ms with hook API mask 0x%08x."),
+		(FPlatformTime::Seconds() - InitializeStartTime) * 1000.0, HookApiMask);
+	return true;
+}
+
+void FGPAPluginRuntimeModule::AddCaptureLayerParameter(const char* Key, const char* Value)
+{
+	// kept for the session sidecars
+	ShimLayerParameters.Emplace(UTF8_TO_TCHAR(Key), UTF8_TO_TCHAR(Value));
+	gpa->AddLayerParameter("capture", Key, Value);
+}
+
+bool FGPAPluginRuntimeModule::EnsureGPAInitialized()
+{
+	check(IsInGameThread());
+
+	if (!bLazyLoadPending)
+	{
+		return gpa != nullptr;
+	}
+
+	// only attempted once, a failed load would fail the same way on every request
+	bLazyLoadPending = false;
+	UE_LOG(GPAPlugin, Log, TEXT("First capture request, loading GPA capture library."));
+
+	LoadThirdPartyLibraries();
+	if (!bAllThirdPartyLibsLoaded || !InitializeGPA())
+	{
+		FreeThirdPartyLibraries();
+		ShowNotification("Failed to load GPA capture library, see log for details.");
+		return false;
+	}
+
+	return true;
+}
+
+void FGPAPluginRuntimeModule::FreeThirdPartyLibraries()
+{
+	for (void* Handle : ThirdPartyLibraryHandles)
+	{
+		if (Handle)
+		{
+			FPlatformProcess::FreeDllHandle(Handle);
+			Handle = nullptr;
+		}
+	}
+	ThirdPartyLibraryHandles.Reset();
+	bAllThirdPartyLibsLoaded = false;
+}
+
+void FGPAPluginRuntimeModule::ShowNotification(const FString& Info)
+{
+	// notifications can be raised from the capture worker, listeners are only called on the game thread
+	if (!IsInGameThread())
+	{
+		AsyncTask(ENamedThreads::GameThread, [this, Info]() { ShowNotification(Info); });
+		return;
+	}
+
+	UE_LOG(GPAPlugin, Log, TEXT("%s"), *Info);
+
+	// the editor module shows these as Slate notifications, packaged builds fall back to on screen messages
+	if (CaptureNotificationDelegate.IsBound())
+	{
+		CaptureNotificationDelegate.Broadcast(Info);
+	}
+	else if (GEngine != nullptr)
+	{
+		GEngine->AddOnScreenDebugMessage(INDEX_NONE, 4.0f, FColor::White, Info);
+	}
+}
+
+void FGPAPluginRuntimeModule::StartGraphicsMonitorProcess()
+{
+	GPA_SCOPED_TIMING(StartGraphicsMonitor);
+
+#if PLATFORM_WINDOWS
+	FString GMPath = "";
+	FString GMBinary = "GpaMonitor.exe";
+
+	// look for Graphics Monitor registry entry
+	FString RegSubKey = TEXT("SOFTWARE\\Intel\\Intel(R) Graphics Performance Analyzers");
+	FWindowsPlatformMisc::QueryRegKey(HKEY_LOCAL_MACHINE, *RegSubKey, TEXT("Location"), GMPath);
+	GMBinary = FPaths::Combine(GMPath, GMBinary);
+
+	if (FPaths::FileExists(GMBinary))
+	{
+		// if Graphics Monitor started by a previous capture or by hand is still running do nothing
+		switch (GraphicsMonitorProcess->LaunchOnce(GMBinary, true))
+		{
+		case EGPAProcessLaunchResult::Launched:
+			ShowNotification("Started Graphics Monitor in new window.");
+			break;
+		case EGPAProcessLaunchResult::AlreadyRunning:
+			break;
+		case EGPAProcessLaunchResult::Failed:
+			UE_LOG(GPAPlugin, Warning, TEXT("Failed to start Graphics Monitor application."));
+			break;
+		}
+	}
+	else
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Could not find valid Graphics Monitor location. Please verify GPA installation."));
+	}
+#else
+	UE_LOG(GPAPlugin, Log, TEXT("Graphics Monitor is only available on Windows, open the stream from %s on a Windows machine."), *GetStreamDirectory());
+#endif
+}
+
+void FGPAPluginRuntimeModule::CaptureStream(const TArray<FString>& Args)
+{	
+	//expecting 'start'/'stop' followed by optional parameters, ignore all other cases
+	if (Args.Num() < 1)
+	{
+		return;
+	}
+
+	// ignore all argumnets other than 'start'/'stop'
+	if (Args[0] == "start")
+	{
+		// frame count from project settings can be overridden with 'frames=N', size and time limits apply on top
+		FGPACaptureRequest Request = { FGPACaptureRequest::EType::Start, CaptureState.AllocateToken(EGPACaptureSource::Console) };
+		for (int32 ArgIndex = 1; ArgIndex < Args.Num(); ++ArgIndex)
+		{
+			FParse::Value(*Args[ArgIndex], TEXT("frames="), Request.FrameCount);
+			FParse::Value(*Args[ArgIndex], TEXT("maxseconds="), Request.MaxSeconds);
+
+			// a limit that does not parse must not silently turn into a different or no limit
+			FString MaxBytes;
+			if (FParse::Value(*Args[ArgIndex], TEXT("maxbytes="), MaxBytes) && !ParseByteSize(MaxBytes, Request.MaxBytes))
+			{
+				UE_LOG(GPAPlugin, Warning, TEXT("GPA capture not started, invalid maxbytes=%s, expecting a size such as 500000, 512M or 1.5G."), *MaxBytes);
+				return;
+			}
+		}
+		ConsoleToken = Request.Token;
+		QueueCaptureRequest(Request);
+	}
+	else if (Args[0] == "stop")
+	{
+		// 'stop force' ends a capture started by any other source
+		FGPACaptureRequest Request = { FGPACaptureRequest::EType::Stop, ConsoleToken };
+		Request.bForce = Args.Contains(TEXT("force"));
+		QueueCaptureRequest(Request);
+	}
+}
+
+bool FGPAPluginRuntimeModule::ParseByteSize(const FString& Text, uint64& OutBytes)
+{
+	FString Number = Text.TrimStartAndEnd();
+	uint64 Scale = 1;
+	if (Number.Len() > 0 && !FChar::IsDigit(Number[Number.Len() - 1]))
+	{
+		switch (FChar::ToUpper(Number[Number.Len() - 1]))
+		{
+		case TEXT('K'): Scale = 1024ull; break;
+		case TEXT('M'): Scale = 1024ull * 1024; break;
+		case TEXT('G'): Scale = 1024ull * 1024 * 1024; break;
+		default: return false;
+		}
+		Number.LeftChopInline(1);
+	}
+
+	// digits with at most one decimal point, so signs, exponents and trailing garbage are rejected
+	int32 NumDigits = 0;
+	int32 NumPoints = 0;
+	for (TCHAR Char : Number)
+	{
+		NumDigits += FChar::IsDigit(Char) ? 1 : 0;
+		NumPoints += Char == TEXT('.') ? 1 : 0;
+		if (!FChar::IsDigit(Char) && Char != TEXT('.'))
+		{
+			return false;
+		}
+	}
+	if (NumDigits == 0 || NumPoints > 1)
+	{
+		return false;
+	}
+
+	const double Bytes = FCString::Atod(*Number) * (double)Scale;
+	if (Bytes < 1.0 || Bytes >= (double)MAX_uint64)
+	{
+		return false;
+	}
+	OutBytes = (uint64)Bytes;
+	return true;
+}
+
+void FGPAPluginRuntimeModule::QueueCaptureRequest(const FGPACaptureRequest& Request)
+{
+	// lock-free, safe to call from any thread, applied by OnEndFrame on the next frame boundary
+	CaptureRequests.Enqueue(Request);
+	NumPendingCaptureRequests.fetch_add(1, std::memory_order_release);
+}
+
+void FGPAPluginRuntimeModule::ProcessCaptureRequests()
+{
+	check(IsInGameThread());
+
+	TArray<FGPACaptureRequest, TInlineAllocator<4>> DeferredRequests;
+
+	FGPACaptureRequest Request;
+	while (CaptureRequests.Dequeue(Request))
+	{
+		NumPendingCaptureRequests.fetch_sub(1, std::memory_order_relaxed);
+
+		switch (Request.Type)
+		{
+		case FGPACaptureRequest::EType::Start:
+			StartStreamCapture(Request.Token, Request.FrameCount, Request.MaxBytes, Request.MaxSeconds);
+			break;
+		case FGPACaptureRequest::EType::Stop:
+			// gameplay code stops its captures unconditionally, ignore them quietly when the capture
+			// already ended on its frame limit or never started because another source owned it
+			if ((Request.Token.Source == EGPACaptureSource::Blueprint || Request.Token.Source == EGPACaptureSource::Code) &&
+				CaptureState.GetOwner() != Request.Token)
+			{
+				break;
+			}
+			// a capture started and stopped within one frame, e.g. by a short scoped capture,
+			// still covers the next frame rather than producing an empty stream
+			if (CaptureState.GetOwner() == Request.Token && ArmedFrameCounter == GFrameCounter)
+			{
+				DeferredRequests.Add(Request);
+				break;
+			}
+			StopStreamCapture(Request.Token, Request.bForce);
+			break;
+		case FGPACaptureRequest::EType::Toggle:
+			if (bFlightRecorderActive)
+			{
+				DumpFlightRecorder();
+			}
+			else if (CaptureState.IsCaptureActive())
+			{
+				StopStreamCapture(ToolbarToken, Request.bForce);
+			}
+			else if (StartStreamCapture(Request.Token, Request.FrameCount, Request.MaxBytes, Request.MaxSeconds) == EGPACaptureStartResult::Started)
+			{
+				ToolbarToken = Request.Token;
+			}
+			break;
+		case FGPACaptureRequest::EType::DumpFlightRecorder:
+			DumpFlightRecorder();
+			break;
+		}
+	}
+
+	for (const FGPACaptureRequest& DeferredRequest : DeferredRequests)
+	{
+		QueueCaptureRequest(DeferredRequest);
+	}
+}
+
+void FGPAPluginRuntimeModule::TriggerStreamCaptureOnRenderThread(const FGPACaptureToken& Token, EGPACaptureState From, EGPACaptureState To, bool bRunGraphicsMonitor, TSharedPtr<FGPACaptureSession, ESPMode::ThreadSafe> Session)
+{
+	// toggling from the render thread places the capture event between the commands of two frames
+	const uint64 EnqueueCycles = FPlatformTime::Cycles64();
+	ENQUEUE_RENDER_COMMAND(GPATriggerStreamCapture)([this, Token, From, To, bRunGraphicsMonitor, EnqueueCycles, Session](FRHICommandListImmediate& RHICmdList)
+	{
+		FGPATimings::Record(EGPATiming::TriggerLatency, FPlatformTime::Cycles64() - EnqueueCycles);
+		{
+			GPA_SCOPED_TIMING(TriggerStreamCapture);
+			gpa->TriggerStreamCapture();
+		}
+
+		// Arming -> Capturing fails if a stop was accepted in the meantime, its toggle follows this one
+		if (CaptureState.TryTransition(Token, From, To) && To == EGPACaptureState::Finalizing)
+		{
+			CaptureWorker->Enqueue([this, Token, bRunGraphicsMonitor, Session]() { FinalizeStreamCapture(Token, bRunGraphicsMonitor, Session); });
+		}
+	});
+}
+
+EGPACaptureStartResult FGPAPluginRuntimeModule::StartStreamCapture(const FGPACaptureToken& Token, int32 FrameCount, uint64 MaxBytes, double MaxSeconds)
+{
+	GPA_SCOPED_TIMING(StartCapture);
+
+	if (bFlightRecorderActive)
+	{
+		ShowNotification("GPA flight recorder is running, use gpa.FlightRecorder dump to save recent frames.");
+		return EGPACaptureStartResult::Failed;
+	}
+
+	// in lazy mode the first capture request pays for loading GPA
+	if (!EnsureGPAInitialized())
+	{
+		return EGPACaptureStartResult::Failed;
+	}
+
+	// only RHIs with a capture backend can be captured, the mock shim also runs on NullRHI
+	if (FGPARHIBackend::FindActive() == nullptr && !bUseMockShim)
+	{
+		ShowNotification(FString::Printf(TEXT("GPA stream capture is not supported for %s RHI.\nSupported RHIs are %s, please change RHI and restart editor."),
+			GDynamicRHI->GetName(), *FGPARHIBackend::GetSupportedRHINames()));
+		return EGPACaptureStartResult::Failed;
+	}
+
+	// the size limit is measured on the stream directory, which the capture layer does not write to
+	if (MaxBytes > 0 && bStreamDirectoryIgnored.load(std::memory_order_relaxed))
+	{
+		UE_LOG(GPAPlugin, Error, TEXT("GPA capture not started, maxbytes= is disabled because the capture layer does not write streams to %s. Use frames= or maxseconds= instead."), *GetStreamDirectory());
+		return EGPACaptureStartResult::Failed;
+	}
+
+	// streams grow quickly, a nearly full disk would only get fuller
+	FString DiskReason;
+	if (DiskBudget.IsValid() && !DiskBudget->CanStartCapture(DiskReason))
+	{
+		ShowNotification(FString::Printf(TEXT("GPA capture not started, %s."), *DiskReason));
+		return EGPACaptureStartResult::Failed;
+	}
+
+	// notify user if a capture session already running and quit
+	// otherwise start capture
+	if (!CaptureState.TryArm(Token))
+	{
+		const FGPACaptureToken Owner = CaptureState.GetOwner();
+		ShowNotification(FString::Printf(TEXT("GPA capture session already running (%s, started by %s)."),
+			FGPACaptureStateMachine::ToString(CaptureState.GetState()), FGPACaptureStateMachine::ToString(Owner.Source)));
+		return EGPACaptureStartResult::Busy;
+	}
+
+	FramesToCapture = FrameCount < 0 ? CVarGPAFrameCaptureCount.GetValueOnGameThread() : FrameCount;
+	FramesToCapture = FMath::Max(FramesToCapture, 0);
+	CapturedFrames = 0;
+	ArmedFrameCounter = GFrameCounter;
+	MaxCaptureBytes = MaxBytes;
+	MaxCaptureSeconds = FMath::Max(MaxSeconds, 0.0);
+
+	// hitch captures are about the frames that hitched and scoped captures about the scope they cover,
+	// schedule, command line and benchmark captures are frame numbered windows that must cover the same frames
+	// on every run, only interactive captures wait in Arming for rendering to settle
+	switch (Token.Source)
+	{
+	case EGPACaptureSource::HitchMonitor:
+	case EGPACaptureSource::Code:
+	case EGPACaptureSource::Schedule:
+	case EGPACaptureSource::CommandLine:
+	case EGPACaptureSource::Benchmark:
+		bArmingGatePending = false;
+		break;
+	default:
+		bArmingGatePending = true;
+		break;
+	}
+	ArmingStartTime = FPlatformTime::Seconds();
+	ArmingNotificationTime = 0.0;
+	TickArmingGate();
+	return EGPACaptureStartResult::Started;
+}
+
+void FGPAPluginRuntimeModule::TickArmingGate()
+{
+	const FString PendingWork = bArmingGatePending ? FGPAArmingGate::GetPendingWork() : FString();
+	if (!PendingWork.IsEmpty())
+	{
+		const double Now = FPlatformTime::Seconds();
+		if (Now - ArmingStartTime < FGPAArmingGate::GetTimeoutSeconds())
+		{
+			// first message right away, then a progress update every couple of seconds
+			if (Now - ArmingNotificationTime >= 2.0)
+			{
+				ArmingNotificationTime = Now;
+				ShowNotification(FString::Printf(TEXT("GPA capture waiting for rendering to settle (%s)."), *PendingWork));
+			}
+			return;
+		}
+		ShowNotification(FString::Printf(TEXT("GPA capture stopped waiting after %.0f s, starting with %s."), Now - ArmingStartTime, *PendingWork));
+	}
+
+	bArmingGatePending = false;
+	ArmedFrameCounter = GFrameCounter;
+	if (FramesToCapture > 0)
+	{
+		ShowNotification(FString::Printf(TEXT("Starting GPA stream capture of %d frames."), FramesToCapture));
+	}
+	else
+	{
+		ShowNotification("Starting GPA stream capture.");
+	}
+
+	// configuration is recorded as the capture starts, frame timings are added while it runs into a ring sized to its limits
+	ActiveSession = MakeShared<FGPACaptureSession, ESPMode::ThreadSafe>(CaptureState.GetOwner(), ShimHookApiMask, ShimLayerParameters,
+		FGPAFrameTimingRing::GetCapacityFor(FramesToCapture, MaxCaptureSeconds));
+	ActiveSession->CaptureEnvironment();
+	if (DiskBudget.IsValid())
+	{
+		DiskBudget->BeginCapture();
+	}
+	CaptureStartTime = FPlatformTime::Seconds();
+
+	// enable RHI ideal capture conditions trigger steam capture start
+	EnableIdealGPUCaptureOptions(true);
+	TriggerStreamCaptureOnRenderThread(CaptureState.GetOwner(), EGPACaptureState::Arming, EGPACaptureState::Capturing);
+}
+
+void FGPAPluginRuntimeModule::TickCaptureLimits()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (MaxCaptureSeconds > 0.0 && Now - CaptureStartTime >= MaxCaptureSeconds)
+	{
+		ShowNotification(FString::Printf(TEXT("GPA capture reached its %.0f s limit, stopping."), MaxCaptureSeconds));
+		StopStreamCapture(CaptureState.GetOwner(), false);
+		return;
+	}
+
+	// the stream is sized on the capture worker a few times a second, this only reads the last measurement
+	if (MaxCaptureBytes > 0 && DiskBudget.IsValid() && DiskBudget->GetCaptureBytes() >= MaxCaptureBytes)
+	{
+		ShowNotification(FString::Printf(TEXT("GPA capture reached its %.1f MB limit, stopping."), (double)MaxCaptureBytes / (1024.0 * 1024.0)));
+		StopStreamCapture(CaptureState.GetOwner(), false);
+	}
+}
+
+bool FGPAPluginRuntimeModule::StopStreamCapture(const FGPACaptureToken& Token, bool bForce)
+{
+	GPA_SCOPED_TIMING(StopCapture);
+
+	if (bFlightRecorderActive)
+	{
+		ShowNotification("GPA flight recorder is running, use gpa.FlightRecorder dump to save recent frames.");
+		return false;
+	}
+
+	if (!CaptureState.IsCaptureActive())
+	{
+		ShowNotification("No GPA capture session running. Start new session to capture stream.");
+		return false;
+	}
+
+	// only the owner can stop a capture, unless the stop is forced
+	const FGPACaptureToken Owner = CaptureState.GetOwner();
+	if (Owner != Token && !bForce)
+	{
+		ShowNotification(FString::Printf(TEXT("GPA capture was started by %s, use 'gpa.StreamCapture stop force' to stop it."),
+			FGPACaptureStateMachine::ToString(Owner.Source)));
+		return false;
+	}
+
+	// a stop accepted while still arming is fine, the stop toggle is enqueued after the start toggle
+	if (!CaptureState.TryBeginStop(Owner))
+	{
+		return false;
+	}
+
+	// nothing was sent to the shim while the capture waited for rendering to settle
+	if (bArmingGatePending)
+	{
+		bArmingGatePending = false;
+		FramesToCapture = 0;
+		CaptureState.TryTransition(Owner, EGPACaptureState::Stopping, EGPACaptureState::Idle);
+		ShowNotification("GPA stream capture cancelled before it started.");
+		return true;
+	}
+
+	// frame time quantiles of the captured window tell whether the stream is worth loading
+	FString StopMessage = FramesToCapture > 0 ? FString::Printf(TEXT("Stopped GPA stream capture after %d frames."), CapturedFrames) : FString(TEXT("Stopped GPA stream capture."));
+	if (ActiveSession.IsValid())
+	{
+		// the captured frames are already on the render thread ahead of the stop toggle,
+		// so walking the console variables here only delays the first frame after the capture
+		ActiveSession->End();
+		ActiveSession->CaptureConsoleVariables();
+		if (ActiveSession->GetFrameTimeHistogram().Num() > 0)
+		{
+			StopMessage += TEXT("\n") + ActiveSession->GetFrameTimeHistogram().ToString();
+		}
+	}
+	ShowNotification(StopMessage);
+	FramesToCapture = 0;
+
+	// trigger steam capture stop event and disable RHI ideal capture conditions,
+	// Graphics Monitor is started from the worker if enabled in settings
+	// the session sidecar is written by the worker once the capture layer stopped
+	TriggerStreamCaptureOnRenderThread(Owner, EGPACaptureState::Stopping, EGPACaptureState::Finalizing, CVarGPARunGPAAfterCapture.GetValueOnAnyThread() != 0, MoveTemp(ActiveSession));
+	EnableIdealGPUCaptureOptions(false);
+	return true;
+}
+
+void FGPAPluginRuntimeModule::EnableIdealGPUCaptureOptions(bool bEnable)
+{
+	const FGPARHIBackend* Backend = FGPARHIBackend::FindActive();
+	if (Backend != nullptr && Backend->bUseIdealGPUCaptureOptions)
+	{
+		GDynamicRHI->EnableIdealGPUCaptureOptions(bEnable);
+	}
+}
+
+void FGPAPluginRuntimeModule::CheckLayerParameters()
+{
+	LayerParameterCheck->QueryLayerHelp(LibraryPath);
+
+	const int32 FlightRecorderFrames = CVarGPAFlightRecorderFrames.GetValueOnAnyThread();
+	if (FlightRecorderFrames > 0 && LayerParameterCheck->GetSupport(FGPALayerParameterCheck::RingBufferFramesParameter) == EGPALayerParameterSupport::NotListed)
+	{
+		UE_LOG(GPAPlugin, Error, TEXT("The installed GPA capture layer does not list the %s parameter, flight recorder dumps hold every frame since the recorder was armed, not the last %d."),
+			UTF8_TO_TCHAR(FGPALayerParameterCheck::RingBufferFramesParameter), FlightRecorderFrames);
+	}
+
+	if (LayerParameterCheck->GetSupport(FGPALayerParameterCheck::OutputDirectoryParameter) == EGPALayerParameterSupport::NotListed)
+	{
+		DisableStreamDirectory(FString::Printf(TEXT("gpa-help does not list the %s parameter"), UTF8_TO_TCHAR(FGPALayerParameterCheck::OutputDirectoryParameter)));
+	}
+}
+
+void FGPAPluginRuntimeModule::DisableStreamDirectory(const FString& Reason)
+{
+	if (bStreamDirectoryIgnored.exchange(true))
+	{
+		return;
+	}
+	UE_LOG(GPAPlugin, Error, TEXT("GPA capture layer does not write streams to %s, %s. Streams go to the capture layer's default location, so the capture disk budget, ")
+		TEXT("gpa.PinStream and maxbytes= are disabled for this session and catalog entries have no stream. Check the capture layer parameters with gpa-help."),
+		*GetStreamDirectory(), *Reason);
+}
+
+void FGPAPluginRuntimeModule::UpdateDiskBudget()
+{
+	// an empty stream directory has nothing to measure or evict
+	if (bStreamDirectoryIgnored.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	const TArray<FString> EvictedStreams = DiskBudget->Update();
+	if (EvictedStreams.Num() > 0 && CaptureCatalog.IsValid())
+	{
+		CaptureCatalog->MarkEvicted(EvictedStreams);
+	}
+}
+
+void FGPAPluginRuntimeModule::FinalizeStreamCapture(const FGPACaptureToken& Token, bool bRunGraphicsMonitor, TSharedPtr<FGPACaptureSession, ESPMode::ThreadSafe> Session)
+{
+	if (Session.IsValid())
+	{
+		// the stream written by this capture is the one the disk budget has not indexed yet
+		if (DiskBudget.IsValid() && !bStreamDirectoryIgnored.load(std::memory_order_relaxed))
+		{
+			Session->SetStreamName(DiskBudget->FindNewStream());
+			if (LayerParameterCheck->OnCaptureFinalized(Session->GetStreamName(), GetStreamDirectory()))
+			{
+				DisableStreamDirectory(TEXT("the first capture left no stream there"));
+			}
+		}
+
+		// the catalog only lists captures whose session file made it to disk
+		if (Session->WriteSidecar() && CaptureCatalog.IsValid())
+		{
+			CaptureCatalog->Add(Session->MakeCatalogEntry());
+		}
+	}
+
+	// the new stream may push the stream directory over budget
+	if (DiskBudget.IsValid())
+	{
+		UpdateDiskBudget();
+
+		if (Session.IsValid() && Token.Source == EGPACaptureSource::FlightRecorder && !Session->GetStreamName().IsEmpty())
+		{
+			LayerParameterCheck->OnFlightRecorderDump(DiskBudget->GetStreamBytes(Session->GetStreamName()), Session->GetFlightRecorderArmedFrames(), Session->GetFlightRecorderFrames());
+		}
+	}
+
+	// process queries may block so this stays off the game thread, a mocked capture has no stream to show
+	if (bRunGraphicsMonitor && !bUseMockShim)
+	{
+		StartGraphicsMonitorProcess();
+	}
+
+	CaptureState.TryTransition(Token, EGPACaptureState::Finalizing, EGPACaptureState::Idle);
+
+	// unattended command line captures end the process once the stream is complete
+	if (Token.Source == EGPACaptureSource::CommandLine)
+	{
+		AsyncTask(ENamedThreads::GameThread, []()
+		{
+			UE_LOG(GPAPlugin, Log, TEXT("Command line GPA capture complete, exiting."));
+			RequestEngineExit(TEXT("GPA command line capture complete"));
+		});
+	}
+}
+
+void FGPAPluginRuntimeModule::OnEndFrame()
+{
+	if (ActiveSession.IsValid() && !bArmingGatePending && CaptureState.IsCaptureActive())
+	{
+		ActiveSession->AddFrame();
+	}
+
+	// count the frame that just ended before applying new requests,
+	// so a capture started on this boundary counts from the next frame
+	if (FramesToCapture > 0 && !bArmingGatePending && CaptureState.IsCaptureActive() && ++CapturedFrames >= FramesToCapture)
+	{
+		StopStreamCapture(CaptureState.GetOwner(), false);
+	}
+
+	if ((MaxCaptureBytes > 0 || MaxCaptureSeconds > 0.0) && !bFlightRecorderActive && !bArmingGatePending && CaptureState.GetState() == EGPACaptureState::Capturing)
+	{
+		TickCaptureLimits();
+	}
+
+	// stop before the disk fills, the flight recorder only writes when dumped
+	if (DiskBudget.IsValid() && !bFlightRecorderActive && !bArmingGatePending && CaptureState.GetState() == EGPACaptureState::Capturing)
+	{
+		if (!bStreamDirectoryIgnored.load(std::memory_order_relaxed) && DiskBudget->IsCaptureMeasurementDue(MaxCaptureBytes > 0))
+		{
+			CaptureWorker->Enqueue([this]() { DiskBudget->MeasureCapture(); });
+		}
+
+		FString DiskReason;
+		if (DiskBudget->ShouldStopCapture(DiskReason))
+		{
+			ShowNotification(FString::Printf(TEXT("GPA capture stopped, %s."), *DiskReason));
+			StopStreamCapture(CaptureState.GetOwner(), true);
+		}
+	}
+
+	if (bArmingGatePending)
+	{
+		TickArmingGate();
+	}
+
+	if (CommandLineCaptureFrame >= 0)
+	{
+		TickCommandLineCapture();
+	}
+
+	// the flight recorder re-arms once the previous dump has been finalized
+	if (bFlightRecorderRearmPending && CaptureState.TryArm(FlightRecorderToken))
+	{
+		bFlightRecorderRearmPending = false;
+		FlightRecorderArmedFrame = GFrameCounter;
+		TriggerStreamCaptureOnRenderThread(FlightRecorderToken, EGPACaptureState::Arming, EGPACaptureState::Capturing);
+	}
+
+	if (NumPendingCaptureRequests.load(std::memory_order_acquire) > 0)
+	{
+		ProcessCaptureRequests();
+	}
+}
+
+void FGPAPluginRuntimeModule::StartFlightRecorder()
+{
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+	PostEngineInitHandle.Reset();
+
+	FlightRecorderToken = CaptureState.AllocateToken(EGPACaptureSource::FlightRecorder);
+	if (gpa == nullptr || !CaptureState.TryArm(FlightRecorderToken))
+	{
+		return;
+	}
+
+	UE_LOG(GPAPlugin, Log, TEXT("Starting GPA flight recorder keeping the last %d frames."), CVarGPAFlightRecorderFrames.GetValueOnAnyThread());
+
+	bFlightRecorderActive = true;
+	FlightRecorderArmedFrame = GFrameCounter;
+	EnableIdealGPUCaptureOptions(true);
+	TriggerStreamCaptureOnRenderThread(FlightRecorderToken, EGPACaptureState::Arming, EGPACaptureState::Capturing);
+}
+
+bool FGPAPluginRuntimeModule::DumpFlightRecorder()
+{
+	if (!bFlightRecorderActive)
+	{
+		ShowNotification("GPA flight recorder is not enabled. Set gpa.FlightRecorderFrames and restart editor.");
+		return false;
+	}
+
+	// a re-arm is still pending from the previous dump, the ring is empty at this point
+	if (!CaptureState.TryBeginStop(FlightRecorderToken))
+	{
+		return false;
+	}
+
+	const int32 FlightRecorderFrames = CVarGPAFlightRecorderFrames.GetValueOnAnyThread();
+	ShowNotification(FString::Printf(TEXT("Writing last %d frames of GPA flight recorder."), FlightRecorderFrames));
+
+	// per-frame timings are not kept for the ring, the dump still records the configuration it was captured with
+	TSharedPtr<FGPACaptureSession, ESPMode::ThreadSafe> Session = MakeShared<FGPACaptureSession, ESPMode::ThreadSafe>(FlightRecorderToken, ShimHookApiMask, ShimLayerParameters, 0);
+	Session->CaptureEnvironment();
+	Session->EndFlightRecorderDump(FlightRecorderFrames, FlightRecorderArmedFrame);
+	Session->CaptureConsoleVariables();
+
+	// stopping the deferred capture writes the ring to disk, re-arm it on a later frame boundary
+	bFlightRecorderRearmPending = true;
+	TriggerStreamCaptureOnRenderThread(FlightRecorderToken, EGPACaptureState::Stopping, EGPACaptureState::Finalizing, false, MoveTemp(Session));
+	return true;
+}
+
+void FGPAPluginRuntimeModule::FlightRecorderCommand(const TArray<FString>& Args)
+{
+	if (Args.Num() == 1 && Args[0] == "dump")
+	{
+		QueueCaptureRequest({ FGPACaptureRequest::EType::DumpFlightRecorder });
+	}
+}
+
+void FGPAPluginRuntimeModule::ListCapturesCommand(const TArray<FString>& Args, FOutputDevice& Ar)
+{
+	// the console command outlives the module, which may be shut down
+	if (!CaptureCatalog.IsValid())
+	{
+		Ar.Logf(TEXT("GPA capture catalog is not available."));
+		return;
+	}
+
+	// every argument except limit=N is a filter term
+	int32 Limit = 20;
+	FString Filter;
+	for (const FString& Arg : Args)
+	{
+		if (!FParse::Value(*Arg, TEXT("limit="), Limit))
+		{
+			Filter += Arg + TEXT(" ");
+		}
+	}
+
+	const TArray<FGPACaptureCatalogEntry> Entries = CaptureCatalog->Find(Filter, FMath::Max(Limit, 1));
+	Ar.Logf(TEXT("%d of %d GPA captures in %s, times in UTC"), Entries.Num(), CaptureCatalog->Num(), *CaptureCatalog->GetCatalogPath());
+	for (const FGPACaptureCatalogEntry& Entry : Entries)
+	{
+		Ar.Logf(TEXT("  %s  %-24s %-16s %-6s %5d frames  mean %6.2f ms  max %6.2f ms  [%s]  %s%s"),
+			*Entry.Time.ToString(TEXT("%Y-%m-%d %H:%M:%S")), *Entry.Map, *Entry.Build, *Entry.RHI, Entry.FrameCount,
+			Entry.MeanFrameMs, Entry.MaxFrameMs, *FString::Join(Entry.Tags, TEXT(",")), *Entry.SessionFile, Entry.bEvicted ? TEXT("  (stream evicted)") : TEXT(""));
+	}
+}
+
+void FGPAPluginRuntimeModule::PinStreamCommand(const TArray<FString>& Args)
+{
+	if (Args.Num() == 0 || Args.Num() > 2 || (Args.Num() == 2 && Args[1] != TEXT("unpin")))
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("Usage: gpa.PinStream <stream name> [unpin]"));
+		return;
+	}
+
+	// the console command outlives the module, and there is no disk budget if startup stopped before the capture worker
+	// or if the capture layer writes its streams elsewhere
+	if (!DiskBudget.IsValid() || bStreamDirectoryIgnored.load(std::memory_order_relaxed))
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("GPA stream directory is not managed in this session."));
+		return;
+	}
+
+	const bool bPin = Args.Num() == 1;
+	if (DiskBudget->SetPinned(Args[0], bPin))
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("GPA stream %s %s."), *Args[0], bPin ? TEXT("pinned, it is never deleted to stay within the capture disk budget") : TEXT("unpinned"));
+	}
+	else
+	{
+		UE_LOG(GPAPlugin, Warning, TEXT("No GPA stream named %s in %s."), *Args[0], *GetStreamDirectory());
+	}
+}
+
+bool FGPAPluginRuntimeModule::OnHitchDetected(const FString& Reason)
+{
+	// a running flight recorder already holds the frames leading up to the hitch
+	if (bFlightRecorderActive)
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("Hitch detected (%s), saving GPA flight recorder."), *Reason);
+		return DumpFlightRecorder();
+	}
+	if (CaptureState.GetState() != EGPACaptureState::Idle)
+	{
+		UE_LOG(GPAPlugin, Verbose, TEXT("Hitch detected (%s) while a GPA capture is running, not capturing."), *Reason);
+		return false;
+	}
+
+	UE_LOG(GPAPlugin, Log, TEXT("Hitch detected (%s), starting GPA stream capture."), *Reason);
+	return StartStreamCapture(CaptureState.AllocateToken(EGPACaptureSource::HitchMonitor), FGPAHitchMonitor::GetCaptureFrameCount()) == EGPACaptureStartResult::Started;
+}
+
+bool FGPAPluginRuntimeModule::OnBenchmarkStartCapture()
+{
+	BenchmarkToken = CaptureState.AllocateToken(EGPACaptureSource::Benchmark);
+	return StartStreamCapture(BenchmarkToken, 0) == EGPACaptureStartResult::Started;
+}
+
+void FGPAPluginRuntimeModule::OnBenchmarkStopCapture()
+{
+	StopStreamCapture(BenchmarkToken, false);
+}
+
+EGPACaptureStartResult FGPAPluginRuntimeModule::OnScheduledCapture(int32 FrameCount)
+{
+	// checked first so a busy window does not show a notification on every frame it waits
+	if (CaptureState.GetState() != EGPACaptureState::Idle)
+	{
+		return EGPACaptureStartResult::Busy;
+	}
+
+	return StartStreamCapture(CaptureState.AllocateToken(EGPACaptureSource::Schedule), FrameCount);
+}
+
+void FGPAPluginRuntimeModule::StartupModule()
+{
+	GPA_SCOPED_TIMING(Startup);
+
+	// Apply settings from ini file, this will update the console variables and project settings
+	// settings saved before the runtime module split live in the editor module section
+	UE::ConfigUtilities::ApplyCVarSettingsFromIni(TEXT("/Script/GPAPlugin.GPAPluginSettings"), *GEngineIni, ECVF_SetByProjectSetting);
+	UE::ConfigUtilities::ApplyCVarSettingsFromIni(TEXT("/Script/GPAPluginRuntime.GPAPluginSettings"), *GEngineIni, ECVF_SetByProjectSetting);
+
+	const bool bCommandLineCapture = ParseCommandLineCapture();
+	bUseMockShim = FParse::Param(FCommandLine::Get(), TEXT("gpamock"));
+	bStreamDirectoryIgnored.store(false);
+
+	// the catalog lists earlier captures even when GPA is not available in this session
+	CaptureCatalog = MakeUnique<FGPACaptureCatalog>(FPaths::Combine(GetCaptureOutputDirectory(), TEXT("CaptureCatalog.jsonl")));
+	static FAutoConsoleCommand CCmdGPAListCaptures = FAutoConsoleCommand(
+		TEXT("gpa.ListCaptures"),
+		TEXT("	[map:<name>] [build:<version>] [rhi:<name>] [source:<name>] [tag:<tag>] [since:<yyyy-mm-dd>] [minms:<ms>] [evicted:<0|1>] [text] [limit=N]: lists the newest captures matching all terms"),
+		FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateRaw(this, &FGPAPluginRuntimeModule::ListCapturesCommand)
+	);
+
+#if WITH_EDITOR
+	// make sure we are running with a valid Windows context, quit if running in command line mode
+	// unless a capture was explicitly requested on the command line or the shim is mocked for a headless run
+	FString ExecutableName = FString(FPlatformProcess::ExecutableName());
+	if (FPaths::GetBaseFilename(ExecutableName).EndsWith("-cmd", ESearchCase::IgnoreCase) && !bCommandLineCapture && !bUseMockShim)
+	{
+		return;
+	}
+#endif
+
+	// a benchmark run stops setting up GPA at the stage its configuration measures
+	FGPABenchmarkSettings BenchmarkSettings;
+	const bool bBenchmark = FGPABenchmark::ParseCommandLine(BenchmarkSettings);
+	if (bBenchmark)
+	{
+		bCaptureLayerDeferred = BenchmarkSettings.bDeferred;
+		Benchmark = MakeUnique<FGPABenchmark>(BenchmarkSettings,
+			FGPABenchmark::FOnStartCapture::CreateRaw(this, &FGPAPluginRuntimeModule::OnBenchmarkStartCapture),
+			FGPABenchmark::FOnStopCapture::CreateRaw(this, &FGPAPluginRuntimeModule::OnBenchmarkStopCapture));
+		if (BenchmarkSettings.Config == EGPABenchmarkConfig::Disabled)
+		{
+			return;
+		}
+	}
+
+	if (!FindThirdPartyLibraries())
+	{
+		if (Benchmark.IsValid())
+		{
+			Benchmark->Abort(TEXT("GPA install not found"));
+		}
+		return;
+	}
+
+	// lazy mode keeps library loads and shim initialization off the startup path until someone captures,
+	// flight recorder, command line captures and benchmarks need the shim from the first frame and always load at startup
+	const bool bPreArm = FParse::Param(FCommandLine::Get(), TEXT("gpaprearm"));
+	if (CVarGPALazyLoad.GetValueOnAnyThread() != 0 && !bPreArm && !bCommandLineCapture && !bBenchmark && CVarGPAFlightRecorderFrames.GetValueOnAnyThread() <= 0)
+	{
+		UE_LOG(GPAPlugin, Log, TEXT("GPA capture library will be loaded on the first capture request, use -gpaprearm to load it at startup."));
+		bLazyLoadPending = true;
+	}
+	else
+	{
+		// Load all 3rd party libraries that have seen delay loaded
+		LoadThirdPartyLibraries();
+		if (bBenchmark && BenchmarkSettings.Config == EGPABenchmarkConfig::Loaded)
+		{
+			if (!bAllThirdPartyLibsLoaded)
+			{
+				Benchmark->Abort(TEXT("GPA libraries could not be loaded"));
+			}
+			return;
+		}
+
+		// if GPA dll found and sucessfully loaded intialize capture process
+		if (!bAllThirdPartyLibsLoaded || !InitializeGPA())
+		{
+			if (Benchmark.IsValid())
+			{
+				Benchmark->Abort(TEXT("GPA capture library could not be initialized"));
+			}
+			return;
+		}
+	}
+
+	// register console variables that tie into the capture start/stop UI button
+	static FAutoConsoleCommand CCmdGPACapturePIE = FAutoConsoleCommand(
+		TEXT("gpa.StreamCapture"),
+		TEXT("	start [frames=N] [maxbytes=N[K|M|G]] [maxseconds=N]: starts GPA stream capture, stopping after N frames if N > 0 (defaults to gpa.FrameCaptureCount),")
+		TEXT(" once the stream reaches maxbytes or after maxseconds, whichever comes first")
+		TEXT("	stop: stops GPA stream capture"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FGPAPluginRuntimeModule::CaptureStream)
+	);
+
+	static FAutoConsoleCommand CCmdGPAFlightRecorder = FAutoConsoleCommand(
+		TEXT("gpa.FlightRecorder"),
+		TEXT("	dump: writes the frames currently held by the flight recorder to disk"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FGPAPluginRuntimeModule::FlightRecorderCommand)
+	);
+
+	GraphicsMonitorProcess = IGPAProcessTracker::Create();
+	LayerParameterCheck = MakeUnique<FGPALayerParameterCheck>();
+	CaptureWorker = MakeUnique<FGPACaptureWorker>();
+
+	// the catalog file grows with every capture, read it before the first gpa.ListCaptures or catalog panel needs it
+	CaptureWorker->Enqueue([this]() { CaptureCatalog->Load(); });
+
+	// the mock shim has no install to ask
+	if (!LibraryPath.IsEmpty())
+	{
+		CaptureWorker->Enqueue([this]() { CheckLayerParameters(); });
+	}
+
+	// the first index sizes every stream once, off the game thread
+	DiskBudget = MakeUnique<FGPADiskBudget>(GetStreamDirectory());
+	CaptureWorker->Enqueue([this]() { UpdateDiskBudget(); });
+	static FAutoConsoleCommand CCmdGPAPinStream = FAutoConsoleCommand(
+		TEXT("gpa.PinStream"),
+		TEXT("	<stream name> [unpin]: pinned streams in the stream directory are never deleted to stay within gpa.CaptureDiskBudgetGB"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FGPAPluginRuntimeModule::PinStreamCommand)
+	);
+
+	// capture requests from all sources are applied on frame boundaries
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FGPAPluginRuntimeModule::OnEndFrame);
+
+	HitchMonitor = MakeUnique<FGPAHitchMonitor>(FGPAHitchMonitor::FOnHitchDetected::CreateRaw(this, &FGPAPluginRuntimeModule::OnHitchDetected));
+
+	// capture schedule from the command line takes precedence over project settings
+	FString SchedulePath = CVarGPACaptureSchedule.GetValueOnAnyThread();
+	FParse::Value(FCommandLine::Get(), TEXT("-gpaschedule="), SchedulePath);
+	if (!SchedulePath.IsEmpty())
+	{
+		CaptureScheduler = MakeUnique<FGPACaptureScheduler>(FGPACaptureScheduler::FOnStartCapture::CreateRaw(this, &FGPAPluginRuntimeModule::OnScheduledCapture));
+		CaptureScheduler->LoadSchedule(FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), SchedulePath));
+	}
+
+	// the flight recorder needs a live RHI, start it once the engine is up
+	if (CVarGPAFlightRecorderFrames.GetValueOnAnyThread() > 0)
+	{
+		PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FGPAPluginRuntimeModule::StartFlightRecorder);
+	}
+}
+
+void FGPAPluginRuntimeModule::ShutdownModule()
+{
+	if (PostEngineInitHandle.IsValid())
+	{
+		FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+		PostEngineInitHandle.Reset();
+	}
+	bFlightRecorderActive = false;
+	bLazyLoadPending = false;
+	HitchMonitor.Reset();
+	CaptureScheduler.Reset();
+	Benchmark.Reset();
+
+	if (EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+
+	// requests queued after the last frame would otherwise be applied by the next startup
+	CaptureRequests.Empty();
+	NumPendingCaptureRequests.store(0, std::memory_order_relaxed);
+
+	// a capture toggle still queued on the render thread may hand finalize work to the worker,
+	// so the render thread is flushed first, then the worker drains before the state its jobs use goes away
+	if (gpa != nullptr)
+	{
+		FlushRenderingCommands();
+	}
+	CaptureWorker.Reset();
+	DiskBudget.Reset();
+	GraphicsMonitorProcess.Reset();
+	LayerParameterCheck.Reset();
+	CaptureCatalog.Reset();
+
+	// Shutdown GPA capture process
+	if (gpa != nullptr)
+	{
+		gpa->Release();
+		gpa = nullptr;
+	}
+
+	FreeThirdPartyLibraries();
+}
+
+#if PLATFORM_WINDOWS
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+IMPLEMENT_MODULE(FGPAPluginRuntimeModule, GPAPluginRuntime)
+
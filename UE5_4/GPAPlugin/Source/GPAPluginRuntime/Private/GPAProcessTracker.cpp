@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAProcessTracker.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <shellapi.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+/** Tracks the launched process through its FProcHandle, the handle is closed once the process exited**/
+class FGPAProcessTracker : public IGPAProcessTracker
+{
+public:
+	virtual ~FGPAProcessTracker()
+	{
+		// the tracked process keeps running, only our handle to it is released
+		FPlatformProcess::CloseProc(ProcessHandle);
+	}
+
+	virtual bool Launch(const FString& ExecutablePath, bool bElevated) override
+	{
+		FPlatformProcess::CloseProc(ProcessHandle);
+
+#if PLATFORM_WINDOWS
+		// CreateProc cannot request elevation, ShellExecuteEx hands back the process handle with SEE_MASK_NOCLOSEPROCESS
+		SHELLEXECUTEINFO shExInfo = { 0 };
+		shExInfo.cbSize = sizeof(shExInfo);
+		shExInfo.fMask = SEE_MASK_NOCLOSEPROCESS;
+		shExInfo.hwnd = 0;
+		shExInfo.lpVerb = bElevated ? L"runas" : L"open";
+		shExInfo.lpFile = *ExecutablePath;       // Application to start    
+		shExInfo.lpParameters = L"";
+		shExInfo.lpDirectory = 0;
+		shExInfo.nShow = SW_SHOW;
+		shExInfo.hInstApp = 0;
+
+		if (!ShellExecuteEx(&shExInfo))
+		{
+			return false;
+		}
+		ProcessHandle = FProcHandle(shExInfo.hProcess);
+#else
+		ProcessHandle = FPlatformProcess::CreateProc(*ExecutablePath, TEXT(""), true, false, false, nullptr, 0, nullptr, nullptr);
+#endif
+		return ProcessHandle.IsValid();
+	}
+
+	virtual bool IsRunning() override
+	{
+		if (!ProcessHandle.IsValid())
+		{
+			return false;
+		}
+
+		// zero timeout wait on the process handle
+		if (FPlatformProcess::IsProcRunning(ProcessHandle))
+		{
+			return true;
+		}
+
+		FPlatformProcess::CloseProc(ProcessHandle);
+		return false;
+	}
+
+	virtual bool IsRunningByName(const FString& ExecutablePath) override
+	{
+		return FPlatformProcess::IsApplicationRunning(*FPaths::GetCleanFilename(ExecutablePath));
+	}
+
+private:
+	FProcHandle ProcessHandle;
+};
+
+EGPAProcessLaunchResult IGPAProcessTracker::LaunchOnce(const FString& ExecutablePath, bool bElevated)
+{
+	// the handle wait covers every capture after the first launch, the process scan only finds instances started by hand
+	if (IsRunning() || IsRunningByName(ExecutablePath))
+	{
+		return EGPAProcessLaunchResult::AlreadyRunning;
+	}
+	return Launch(ExecutablePath, bElevated) ? EGPAProcessLaunchResult::Launched : EGPAProcessLaunchResult::Failed;
+}
+
+TUniquePtr<IGPAProcessTracker> IGPAProcessTracker::Create()
+{
+	return MakeUnique<FGPAProcessTracker>();
+}
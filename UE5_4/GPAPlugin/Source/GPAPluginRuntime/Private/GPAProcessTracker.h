@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Outcome of IGPAProcessTracker::LaunchOnce**/
+enum class EGPAProcessLaunchResult : uint8
+{
+	Launched,
+	/** The process launched before, or one started outside the plugin, still runs and is reused**/
+	AlreadyRunning,
+	Failed
+};
+
+/**
+ * Tracks a helper process launched by the plugin, e.g. Graphics Monitor, through the handle returned at launch,
+ * so checking whether it still runs is a single non-blocking wait instead of a scan of all system processes.
+ * Instances started by hand are only found by that scan, which runs while no launched process is tracked.
+ * Implementations are not thread safe, the plugin only uses them from the capture worker.
+ */
+class IGPAProcessTracker
+{
+public:
+	virtual ~IGPAProcessTracker() = default;
+
+	/** Launches the executable and starts tracking it, replacing any process tracked before, returns false on failure**/
+	virtual bool Launch(const FString& ExecutablePath, bool bElevated) = 0;
+	/** True while the last launched process is running, never blocks**/
+	virtual bool IsRunning() = 0;
+	/** True if any process of the executable's name runs, including ones not launched by the tracker, scans all system processes**/
+	virtual bool IsRunningByName(const FString& ExecutablePath) = 0;
+
+	/** Launches the executable unless the process launched before or another instance of it runs, so repeated captures share one instance**/
+	EGPAProcessLaunchResult LaunchOnce(const FString& ExecutablePath, bool bElevated);
+
+	/** Tracker for the current platform**/
+	static TUniquePtr<IGPAProcessTracker> Create();
+};
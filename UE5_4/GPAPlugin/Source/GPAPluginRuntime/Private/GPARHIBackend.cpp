@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPARHIBackend.h"
+#include "DynamicRHI.h"
+
+static TConstArrayView<FGPARHIBackend> GetBackends()
+{
+	static const FGPARHIBackend Backends[] =
+	{
+		{ TEXT("D3D12"), TEXT("D3D12RHI"), gpa::utility::kHookD3D12, true },
+		{ TEXT("D3D11"), TEXT("D3D11RHI"), gpa::utility::kHookD3D11, true },
+		{ TEXT("Vulkan"), TEXT("VulkanRHI"), gpa::utility::kHookVulkan, true },
+	};
+	return Backends;
+}
+
+const FGPARHIBackend* FGPARHIBackend::FindActive()
+{
+	if (GDynamicRHI == nullptr)
+	{
+		return nullptr;
+	}
+
+	const TCHAR* RHIName = GDynamicRHI->GetName();
+	for (const FGPARHIBackend& Backend : GetBackends())
+	{
+		if (FCString::Strcmp(RHIName, Backend.RHIName) == 0)
+		{
+			return &Backend;
+		}
+	}
+	return nullptr;
+}
+
+const FGPARHIBackend* FGPARHIBackend::FindSelected()
+{
+	const FString RHIModuleName = GetSelectedDynamicRHIModuleName(false);
+	for (const FGPARHIBackend& Backend : GetBackends())
+	{
+		if (RHIModuleName == Backend.RHIModuleName)
+		{
+			return &Backend;
+		}
+	}
+	return nullptr;
+}
+
+FString FGPARHIBackend::GetSupportedRHINames()
+{
+	FString Names;
+	for (const FGPARHIBackend& Backend : GetBackends())
+	{
+		Names += Names.IsEmpty() ? Backend.RHIName : FString::Printf(TEXT(", %s"), Backend.RHIName);
+	}
+	return Names;
+}
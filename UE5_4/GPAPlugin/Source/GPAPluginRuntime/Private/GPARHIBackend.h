@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GPAPluginRuntimeModule.h"
+
+/**
+ * Describes how GPA captures one RHI: the APIs the shim has to hook and whether the RHI is switched
+ * to ideal capture conditions while capturing. The capture layer takes the same parameters for every API.
+ * An RHI without an entry cannot be captured.
+ */
+struct FGPARHIBackend
+{
+	/** Name returned by FDynamicRHI::GetName once the RHI exists**/
+	const TCHAR* RHIName;
+	/** Module returned by GetSelectedDynamicRHIModuleName, used at startup before the RHI is created**/
+	const TCHAR* RHIModuleName;
+	/** APIs hooked when gpa.HookApiMask is 0, Win32 is added on Windows**/
+	gpa::utility::HookApiFlags HookApiMask;
+	/** Call EnableIdealGPUCaptureOptions around captures**/
+	bool bUseIdealGPUCaptureOptions;
+
+	/** Backend of the running RHI, nullptr if it cannot be captured or no RHI exists yet**/
+	static const FGPARHIBackend* FindActive();
+	/** Backend of the RHI the engine will create, usable before the RHI exists**/
+	static const FGPARHIBackend* FindSelected();
+	/** Comma separated names of all RHIs that can be captured, for user messages**/
+	static FString GetSupportedRHINames();
+};
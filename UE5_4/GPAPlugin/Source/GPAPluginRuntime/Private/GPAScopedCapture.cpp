@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAScopedCapture.h"
+
+#if WITH_GPA_CAPTURE
+
+#include "GPAPluginRuntimeModule.h"
+
+FScopedGPACapture::FScopedGPACapture(int32 MaxFrameCount)
+{
+	FGPAPluginRuntimeModule& RuntimeModule = FGPAPluginRuntimeModule::Get();
+	if (!RuntimeModule.IsCaptureAvailable())
+	{
+		return;
+	}
+
+	FGPACaptureRequest Request = { FGPACaptureRequest::EType::Start, RuntimeModule.AllocateCaptureToken(EGPACaptureSource::Code) };
+	Request.FrameCount = FMath::Max(MaxFrameCount, 0);
+	RuntimeModule.QueueCaptureRequest(Request);
+	Token = Request.Token;
+}
+
+FScopedGPACapture::~FScopedGPACapture()
+{
+	if (Token.IsValid())
+	{
+		FGPAPluginRuntimeModule::Get().QueueCaptureRequest({ FGPACaptureRequest::EType::Stop, Token });
+	}
+}
+
+#endif // WITH_GPA_CAPTURE
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPATimings.h"
+#include "GPABenchmark.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_STAT(STAT_GPA_Startup);
+DEFINE_STAT(STAT_GPA_LoadLibraries);
+DEFINE_STAT(STAT_GPA_GetInterface);
+DEFINE_STAT(STAT_GPA_Initialize);
+DEFINE_STAT(STAT_GPA_StartGraphicsMonitor);
+DEFINE_STAT(STAT_GPA_StartCapture);
+DEFINE_STAT(STAT_GPA_StopCapture);
+DEFINE_STAT(STAT_GPA_TriggerStreamCapture);
+
+FGPATimings::FEntry FGPATimings::Entries[(int32)EGPATiming::Num];
+
+static FAutoConsoleCommandWithOutputDevice CCmdGPADumpTimings(
+	TEXT("gpa.DumpTimings"),
+	TEXT("Prints time spent in GPA plugin startup, shim calls and capture start/stop, and the frame time, memory and startup overhead of benchmark runs against runs without the plugin"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FGPATimings::Dump)
+);
+
+void FGPATimings::Record(EGPATiming Timing, uint64 Cycles)
+{
+	FEntry& Entry = Entries[(int32)Timing];
+	Entry.Count.fetch_add(1, std::memory_order_relaxed);
+	Entry.TotalCycles.fetch_add(Cycles, std::memory_order_relaxed);
+	Entry.LastCycles.store(Cycles, std::memory_order_relaxed);
+
+	uint64 MaxCycles = Entry.MaxCycles.load(std::memory_order_relaxed);
+	while (Cycles > MaxCycles && !Entry.MaxCycles.compare_exchange_weak(MaxCycles, Cycles, std::memory_order_relaxed))
+	{
+	}
+}
+
+void FGPATimings::Dump(FOutputDevice& Ar)
+{
+	Ar.Logf(TEXT("%-26s %8s %10s %10s %10s"), TEXT("GPA timing"), TEXT("Count"), TEXT("Last ms"), TEXT("Avg ms"), TEXT("Max ms"));
+	for (int32 Index = 0; Index < (int32)EGPATiming::Num; ++Index)
+	{
+		const FEntry& Entry = Entries[Index];
+		const uint32 Count = Entry.Count.load(std::memory_order_relaxed);
+		if (Count == 0)
+		{
+			continue;
+		}
+
+		Ar.Logf(TEXT("%-26s %8u %10.3f %10.3f %10.3f"), ToString((EGPATiming)Index), Count,
+			FPlatformTime::ToMilliseconds64(Entry.LastCycles.load(std::memory_order_relaxed)),
+			FPlatformTime::ToMilliseconds64(Entry.TotalCycles.load(std::memory_order_relaxed)) / Count,
+			FPlatformTime::ToMilliseconds64(Entry.MaxCycles.load(std::memory_order_relaxed)));
+	}
+
+	// timings above only cover plugin code, frame cost of the hooks themselves needs a run without the plugin to compare to
+	FGPABenchmark::DumpOverhead(FGPABenchmark::GetDefaultCsvPath(), Ar);
+}
+
+double FGPATimings::GetTotalMilliseconds(EGPATiming Timing)
+{
+	return FPlatformTime::ToMilliseconds64(Entries[(int32)Timing].TotalCycles.load(std::memory_order_relaxed));
+}
+
+const TCHAR* FGPATimings::ToString(EGPATiming Timing)
+{
+	switch (Timing)
+	{
+	case EGPATiming::Startup: return TEXT("Startup");
+	case EGPATiming::LoadLibraries: return TEXT("LoadLibraries");
+	case EGPATiming::GetInterface: return TEXT("GetInterface");
+	case EGPATiming::Initialize: return TEXT("Initialize");
+	case EGPATiming::StartGraphicsMonitor: return TEXT("StartGraphicsMonitor");
+	case EGPATiming::StartCapture: return TEXT("StartCapture");
+	case EGPATiming::StopCapture: return TEXT("StopCapture");
+	case EGPATiming::TriggerStreamCapture: return TEXT("TriggerStreamCapture");
+	case EGPATiming::TriggerLatency: return TEXT("TriggerLatency");
+	default: return TEXT("Unknown");
+	}
+}
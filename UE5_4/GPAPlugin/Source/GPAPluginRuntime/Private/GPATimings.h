@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include <atomic>
+
+DECLARE_STATS_GROUP(TEXT("GPA"), STATGROUP_GPA, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Module startup"), STAT_GPA_Startup, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Load third party libraries"), STAT_GPA_LoadLibraries, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetGPAInterface"), STAT_GPA_GetInterface, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("IGPA::Initialize"), STAT_GPA_Initialize, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Start Graphics Monitor"), STAT_GPA_StartGraphicsMonitor, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Start capture"), STAT_GPA_StartCapture, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Stop capture"), STAT_GPA_StopCapture, STATGROUP_GPA, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("IGPA::TriggerStreamCapture"), STAT_GPA_TriggerStreamCapture, STATGROUP_GPA, );
+
+/** Plugin operations whose cost is tracked for gpa.DumpTimings**/
+enum class EGPATiming : uint8
+{
+	Startup,
+	LoadLibraries,
+	GetInterface,
+	Initialize,
+	StartGraphicsMonitor,
+	StartCapture,
+	StopCapture,
+	TriggerStreamCapture,
+	/** Time from a capture toggle being enqueued on the game thread until the render thread emits it**/
+	TriggerLatency,
+	Num
+};
+
+/**
+ * Accumulated plugin timings, unlike stats these are kept in all non-shipping configurations and include
+ * startup work done before the stats system runs. Recording is lock-free and can happen on any thread.
+ */
+class FGPATimings
+{
+public:
+	static void Record(EGPATiming Timing, uint64 Cycles);
+	/** Writes count, last, average and maximum duration of every timing to Ar, followed by the plugin overhead
+	    measured by benchmark runs, see FGPABenchmark::DumpOverhead**/
+	static void Dump(FOutputDevice& Ar);
+	/** Total duration of every recorded Timing, in milliseconds**/
+	static double GetTotalMilliseconds(EGPATiming Timing);
+	static const TCHAR* ToString(EGPATiming Timing);
+
+private:
+	struct FEntry
+	{
+		std::atomic<uint32> Count{ 0 };
+		std::atomic<uint64> TotalCycles{ 0 };
+		std::atomic<uint64> LastCycles{ 0 };
+		std::atomic<uint64> MaxCycles{ 0 };
+	};
+	static FEntry Entries[(int32)EGPATiming::Num];
+};
+
+/** Records the lifetime of the scope into FGPATimings**/
+struct FGPAScopedTiming
+{
+	explicit FGPAScopedTiming(EGPATiming InTiming) : Timing(InTiming), StartCycles(FPlatformTime::Cycles64()) {}
+	~FGPAScopedTiming() { FGPATimings::Record(Timing, FPlatformTime::Cycles64() - StartCycles); }
+
+private:
+	EGPATiming Timing;
+	uint64 StartCycles;
+};
+
+/** Times the enclosing scope as stat gpa cycle counter, Unreal Insights CPU event and gpa.DumpTimings entry**/
+#define GPA_SCOPED_TIMING(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_STR("GPA::" #Name); \
+	SCOPE_CYCLE_COUNTER(STAT_GPA_##Name); \
+	FGPAScopedTiming ANONYMOUS_VARIABLE(GPAScopedTiming)(EGPATiming::Name)
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAProcessTracker.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Stand-in for the system process table, processes only start and exit when a test says so**/
+struct FGPAFakeProcessTable
+{
+	struct FProcess
+	{
+		FString ExecutablePath;
+		bool bElevated = false;
+		bool bRunning = true;
+	};
+
+	TArray<FProcess> Processes;
+	/** Makes the next launches fail, as a missing executable or a declined elevation prompt would**/
+	bool bFailLaunch = false;
+	/** Number of IsRunning queries, each one stands for a wait on a process handle**/
+	int32 NumQueries = 0;
+	/** Number of IsRunningByName queries, each one stands for a scan of all system processes**/
+	int32 NumScans = 0;
+
+	void Exit(int32 ProcessId) { Processes[ProcessId].bRunning = false; }
+	int32 NumRunning() const { return Processes.FilterByPredicate([](const FProcess& Process) { return Process.bRunning; }).Num(); }
+};
+
+/** Tracks a process of the fake table by its index, as the platform tracker does by its handle**/
+class FGPAFakeProcessTracker : public IGPAProcessTracker
+{
+public:
+	explicit FGPAFakeProcessTracker(FGPAFakeProcessTable& InTable) : Table(InTable), ProcessId(INDEX_NONE) {}
+
+	virtual bool Launch(const FString& ExecutablePath, bool bElevated) override
+	{
+		ProcessId = INDEX_NONE;
+		if (Table.bFailLaunch)
+		{
+			return false;
+		}
+		ProcessId = Table.Processes.Add({ ExecutablePath, bElevated });
+		return true;
+	}
+
+	virtual bool IsRunning() override
+	{
+		++Table.NumQueries;
+		return ProcessId != INDEX_NONE && Table.Processes[ProcessId].bRunning;
+	}
+
+	virtual bool IsRunningByName(const FString& ExecutablePath) override
+	{
+		++Table.NumScans;
+		return Table.Processes.ContainsByPredicate([&ExecutablePath](const FGPAFakeProcessTable::FProcess& Process)
+		{
+			return Process.bRunning && FPaths::GetCleanFilename(Process.ExecutablePath) == FPaths::GetCleanFilename(ExecutablePath);
+		});
+	}
+
+	int32 GetProcessId() const { return ProcessId; }
+
+private:
+	FGPAFakeProcessTable& Table;
+	int32 ProcessId;
+};
+
+BEGIN_DEFINE_SPEC(FGPAProcessTrackerSpec, "GPAPlugin.ProcessTracker", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	FGPAFakeProcessTable Table;
+	TUniquePtr<FGPAFakeProcessTracker> Tracker;
+END_DEFINE_SPEC(FGPAProcessTrackerSpec)
+
+void FGPAProcessTrackerSpec::Define()
+{
+	static const TCHAR* MonitorPath = TEXT("/opt/gpa/GpaMonitor");
+
+	BeforeEach([this]()
+	{
+		Table = FGPAFakeProcessTable();
+		Tracker = MakeUnique<FGPAFakeProcessTracker>(Table);
+	});
+
+	AfterEach([this]()
+	{
+		Tracker.Reset();
+	});
+
+	Describe("LaunchOnce", [this]()
+	{
+		It("starts Graphics Monitor when none is tracked", [this]()
+		{
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::Launched);
+			TestEqual(TEXT("Processes"), Table.Processes.Num(), 1);
+			TestEqual(TEXT("Executable"), Table.Processes[0].ExecutablePath, FString(MonitorPath));
+			TestTrue(TEXT("Elevated"), Table.Processes[0].bElevated);
+			TestTrue(TEXT("Running"), Tracker->IsRunning());
+		});
+
+		It("reuses the running instance on later captures", [this]()
+		{
+			Tracker->LaunchOnce(MonitorPath, true);
+			for (int32 Capture = 0; Capture < 3; ++Capture)
+			{
+				TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::AlreadyRunning);
+			}
+			TestEqual(TEXT("Processes"), Table.Processes.Num(), 1);
+			// one handle wait per capture, the process table is only scanned before the first launch
+			TestEqual(TEXT("Queries"), Table.NumQueries, 4);
+			TestEqual(TEXT("Scans"), Table.NumScans, 1);
+		});
+
+		It("starts a new instance once the tracked one exited", [this]()
+		{
+			Tracker->LaunchOnce(MonitorPath, true);
+			Table.Exit(Tracker->GetProcessId());
+			TestFalse(TEXT("Running after exit"), Tracker->IsRunning());
+
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::Launched);
+			TestEqual(TEXT("Processes"), Table.Processes.Num(), 2);
+			TestEqual(TEXT("Tracked process"), Tracker->GetProcessId(), 1);
+			TestEqual(TEXT("Running processes"), Table.NumRunning(), 1);
+		});
+
+		It("reuses an instance started by hand", [this]()
+		{
+			// e.g. Graphics Monitor opened by the user from another install location
+			Table.Processes.Add({ TEXT("/home/user/gpa/GpaMonitor"), false });
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::AlreadyRunning);
+			TestEqual(TEXT("Processes"), Table.Processes.Num(), 1);
+			TestEqual(TEXT("Tracked process"), Tracker->GetProcessId(), (int32)INDEX_NONE);
+		});
+
+		It("starts a new instance once the one started by hand exited", [this]()
+		{
+			Table.Processes.Add({ MonitorPath, false });
+			Tracker->LaunchOnce(MonitorPath, true);
+			Table.Exit(0);
+
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::Launched);
+			TestEqual(TEXT("Tracked process"), Tracker->GetProcessId(), 1);
+		});
+
+		It("ignores other executables", [this]()
+		{
+			Table.Processes.Add({ TEXT("/opt/gpa/GpaPlayer"), false });
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::Launched);
+			TestEqual(TEXT("Tracked process"), Tracker->GetProcessId(), 1);
+		});
+
+		It("reports a failed launch and retries on the next capture", [this]()
+		{
+			Table.bFailLaunch = true;
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::Failed);
+			TestFalse(TEXT("Running"), Tracker->IsRunning());
+
+			Table.bFailLaunch = false;
+			TestEqual(TEXT("Result after retry"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::Launched);
+			TestEqual(TEXT("Processes"), Table.Processes.Num(), 1);
+		});
+
+		It("stops tracking a process that was replaced", [this]()
+		{
+			Tracker->LaunchOnce(MonitorPath, true);
+			const int32 FirstProcessId = Tracker->GetProcessId();
+			Tracker->Launch(MonitorPath, true);
+			Table.Exit(FirstProcessId);
+			TestTrue(TEXT("Replacement running"), Tracker->IsRunning());
+			TestEqual(TEXT("Result"), Tracker->LaunchOnce(MonitorPath, true), EGPAProcessLaunchResult::AlreadyRunning);
+		});
+	});
+
+	Describe("Platform tracker", [this]()
+	{
+		It("tracks nothing before the first launch", [this]()
+		{
+			TUniquePtr<IGPAProcessTracker> PlatformTracker = IGPAProcessTracker::Create();
+			TestFalse(TEXT("Running"), PlatformTracker->IsRunning());
+		});
+
+		It("does not find an executable that is not running", [this]()
+		{
+			TUniquePtr<IGPAProcessTracker> PlatformTracker = IGPAProcessTracker::Create();
+			TestFalse(TEXT("Running"), PlatformTracker->IsRunningByName(TEXT("/opt/gpa/GpaMonitorNotInstalled")));
+		});
+	});
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,478 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "GPAPluginRuntimeModule.h"
+#include "GPAMockShim.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Time a single step may wait for the capture to reach a state, generous for loaded build machines**/
+static constexpr double GPATestStepTimeoutSeconds = 10.0;
+
+/**
+ * Drives the runtime module against FGPAMockShim the way users do, through gpa.StreamCapture and the capture request
+ * queue, one frame boundary at a time. Run headless with -nullrhi -gpamock, e.g.
+ * UnrealEditor-Cmd <project> -nullrhi -gpamock -ExecCmds="Automation RunTests GPAPlugin;Quit"
+ */
+BEGIN_DEFINE_SPEC(FGPAStreamCaptureSpec, "GPAPlugin.StreamCapture", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+	/** A step returns true once done, steps returning false are retried every frame until they time out**/
+	using FStep = TFunction<bool()>;
+
+	FGPAPluginRuntimeModule* RuntimeModule = nullptr;
+	/** Console variables changed for the test and their values before it**/
+	TArray<TPair<FString, FString>> SavedConsoleVariables;
+	/** Mock calls made before the test started, only later calls are checked**/
+	int32 NumCallsBefore = 0;
+	/** Engine frame and time a step recorded for later checks**/
+	uint64 MarkedFrame = 0;
+	double MarkedTime = 0.0;
+
+	void RunSteps(const FDoneDelegate& Done, TArray<FStep>&& Steps);
+	/** Step that waits for Frames frame boundaries**/
+	FStep WaitFrames(int32 Frames);
+	FStep WaitForState(EGPACaptureState State);
+
+	void Exec(const FString& Command);
+	void SetConsoleVariable(const TCHAR* Name, const TCHAR* Value);
+	/** Number of start or stop toggles the mock received since the test started**/
+	int32 CountTriggers(const TCHAR* Toggle) const;
+	/** Restarts the module with extra command line switches, restored from OriginalCommandLine afterwards**/
+	void RestartModule(const FString& CommandLine);
+
+	FString OriginalCommandLine;
+
+END_DEFINE_SPEC(FGPAStreamCaptureSpec)
+
+void FGPAStreamCaptureSpec::RunSteps(const FDoneDelegate& Done, TArray<FStep>&& Steps)
+{
+	struct FRun
+	{
+		TArray<FStep> Steps;
+		int32 Index = 0;
+		double StepStartTime = 0.0;
+	};
+	TSharedRef<FRun> Run = MakeShared<FRun>();
+	Run->Steps = MoveTemp(Steps);
+	Run->StepStartTime = FPlatformTime::Seconds();
+
+	// the core ticker runs once per frame before OnEndFrame, so requests queued by a step are applied on the same frame
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, Run, Done](float)
+	{
+		const double Now = FPlatformTime::Seconds();
+		while (Run->Index < Run->Steps.Num() && Run->Steps[Run->Index]())
+		{
+			++Run->Index;
+			Run->StepStartTime = Now;
+		}
+
+		if (Run->Index == Run->Steps.Num())
+		{
+			Done.Execute();
+			return false;
+		}
+		if (Now - Run->StepStartTime > GPATestStepTimeoutSeconds)
+		{
+			AddError(FString::Printf(TEXT("Step %d timed out in capture state %s."), Run->Index,
+				FGPACaptureStateMachine::ToString(RuntimeModule->GetCaptureState().GetState())));
+			Done.Execute();
+			return false;
+		}
+		return true;
+	}));
+}
+
+FGPAStreamCaptureSpec::FStep FGPAStreamCaptureSpec::WaitFrames(int32 Frames)
+{
+	TSharedRef<uint64> EndFrame = MakeShared<uint64>(0);
+	return [EndFrame, Frames]()
+	{
+		if (*EndFrame == 0)
+		{
+			*EndFrame = GFrameCounter + Frames;
+		}
+		return GFrameCounter >= *EndFrame;
+	};
+}
+
+FGPAStreamCaptureSpec::FStep FGPAStreamCaptureSpec::WaitForState(EGPACaptureState State)
+{
+	return [this, State]() { return RuntimeModule->GetCaptureState().GetState() == State; };
+}
+
+void FGPAStreamCaptureSpec::Exec(const FString& Command)
+{
+	IConsoleManager::Get().ProcessUserConsoleInput(*Command, *GLog, nullptr);
+}
+
+void FGPAStreamCaptureSpec::SetConsoleVariable(const TCHAR* Name, const TCHAR* Value)
+{
+	IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name);
+	if (Variable == nullptr)
+	{
+		AddError(FString::Printf(TEXT("No console variable %s."), Name));
+		return;
+	}
+	SavedConsoleVariables.Emplace(Name, Variable->GetString());
+	Variable->Set(Value, ECVF_SetByCode);
+}
+
+int32 FGPAStreamCaptureSpec::CountTriggers(const TCHAR* Toggle) const
+{
+	const FGPAMockShim* Mock = FGPAMockShim::Get();
+	if (Mock == nullptr)
+	{
+		return 0;
+	}
+
+	int32 Count = 0;
+	const TArray<FGPAMockShim::FCall> Calls = Mock->GetCalls();
+	for (int32 Index = NumCallsBefore; Index < Calls.Num(); ++Index)
+	{
+		Count += Calls[Index].Call == FGPAMockShim::ECall::TriggerStreamCapture && Calls[Index].Arguments == Toggle ? 1 : 0;
+	}
+	return Count;
+}
+
+void FGPAStreamCaptureSpec::RestartModule(const FString& CommandLine)
+{
+	// headless runs have no editor UI holding on to the catalog or worker, so the module can be cycled in place
+	FCommandLine::Set(*CommandLine);
+	RuntimeModule->ShutdownModule();
+	RuntimeModule->StartupModule();
+	NumCallsBefore = 0;
+}
+
+void FGPAStreamCaptureSpec::Define()
+{
+	// a real shim would need a GPU and write actual streams, the spec only runs against the mock
+	if (!FParse::Param(FCommandLine::Get(), TEXT("gpamock")))
+	{
+		It("needs -gpamock", [this]()
+		{
+			AddWarning(TEXT("GPA stream capture tests were skipped, run with -nullrhi -gpamock."));
+		});
+		return;
+	}
+
+	BeforeEach([this]()
+	{
+		RuntimeModule = &FGPAPluginRuntimeModule::Get();
+		OriginalCommandLine = FCommandLine::Get();
+
+		// nothing may start or hold back a capture behind the test's back
+		SetConsoleVariable(TEXT("gpa.ArmWaitForCompilation"), TEXT("0"));
+		SetConsoleVariable(TEXT("gpa.ArmWaitForStreaming"), TEXT("0"));
+		SetConsoleVariable(TEXT("gpa.HitchThresholdMs"), TEXT("0"));
+		SetConsoleVariable(TEXT("gpa.MinFreeDiskSpaceGB"), TEXT("0"));
+		SetConsoleVariable(TEXT("gpa.CaptureDiskBudgetGB"), TEXT("0"));
+		SetConsoleVariable(TEXT("gpa.MockTriggerLatencyMs"), TEXT("0"));
+
+		const FGPAMockShim* Mock = FGPAMockShim::Get();
+		NumCallsBefore = Mock != nullptr ? Mock->GetCalls().Num() : 0;
+	});
+
+	LatentAfterEach([this](const FDoneDelegate& Done)
+	{
+		RunSteps(Done, {
+			[this]()
+			{
+				if (RuntimeModule->GetCaptureState().IsCaptureActive())
+				{
+					Exec(TEXT("gpa.StreamCapture stop force"));
+				}
+				return true;
+			},
+			WaitForState(EGPACaptureState::Idle),
+			[this]()
+			{
+				for (int32 Index = SavedConsoleVariables.Num() - 1; Index >= 0; --Index)
+				{
+					IConsoleManager::Get().FindConsoleVariable(*SavedConsoleVariables[Index].Key)->Set(*SavedConsoleVariables[Index].Value, ECVF_SetByCode);
+				}
+				SavedConsoleVariables.Reset();
+
+				// a test that restarted the module leaves it as the command line configured it
+				if (OriginalCommandLine != FCommandLine::Get())
+				{
+					RestartModule(OriginalCommandLine);
+				}
+				return true;
+			}
+		});
+	});
+
+	Describe("gpa.StreamCapture", [this]()
+	{
+		LatentIt("starts and stops a capture", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				[this]() { Exec(TEXT("gpa.StreamCapture start frames=0")); return true; },
+				WaitForState(EGPACaptureState::Capturing),
+				[this]()
+				{
+					TestTrue(TEXT("Mock shim is capturing"), FGPAMockShim::Get() != nullptr && FGPAMockShim::Get()->IsCapturing());
+					TestEqual(TEXT("Capture owner"), RuntimeModule->GetCaptureState().GetOwner().Source, EGPACaptureSource::Console);
+					Exec(TEXT("gpa.StreamCapture stop"));
+					return true;
+				},
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					TestEqual(TEXT("Start toggles"), CountTriggers(TEXT("start")), 1);
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 1);
+					TestFalse(TEXT("Mock shim is capturing"), FGPAMockShim::Get()->IsCapturing());
+					return true;
+				}
+			});
+		});
+
+		LatentIt("stops on its own after frames=N", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				[this]()
+				{
+					MarkedFrame = GFrameCounter;
+					Exec(TEXT("gpa.StreamCapture start frames=3"));
+					return true;
+				},
+				WaitForState(EGPACaptureState::Capturing),
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					TestTrue(TEXT("Capture covered 3 frames"), GFrameCounter >= MarkedFrame + 3);
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 1);
+					return true;
+				}
+			});
+		});
+
+		LatentIt("stops once the stream reaches maxbytes=", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				[this]() { Exec(TEXT("gpa.StreamCapture start frames=0 maxbytes=1K")); return true; },
+				WaitForState(EGPACaptureState::Capturing),
+				WaitFrames(2),
+				[this]()
+				{
+					TestEqual(TEXT("Capture below maxbytes keeps running"), RuntimeModule->GetCaptureState().GetState(), EGPACaptureState::Capturing);
+
+					// the mock stream stands in for the capture layer writing frames
+					const FString StreamPath = FGPAMockShim::Get()->GetLastStreamPath();
+					TestFalse(TEXT("Mock stream created in the stream directory"), StreamPath.IsEmpty());
+					TArray<uint8> Frames;
+					Frames.SetNumZeroed(4096);
+					FFileHelper::SaveArrayToFile(Frames, *FPaths::Combine(StreamPath, TEXT("frames.bin")));
+					return true;
+				},
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 1);
+					return true;
+				}
+			});
+		});
+
+		LatentIt("stops after maxseconds=", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				[this]() { Exec(TEXT("gpa.StreamCapture start frames=0 maxseconds=0.5")); return true; },
+				WaitForState(EGPACaptureState::Capturing),
+				[this]() { MarkedTime = FPlatformTime::Seconds(); return true; },
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					TestTrue(TEXT("Capture ran for maxseconds"), FPlatformTime::Seconds() - MarkedTime >= 0.4);
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 1);
+					return true;
+				}
+			});
+		});
+
+		LatentIt("refuses maxbytes= values that do not parse", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				[this]()
+				{
+					AddExpectedError(TEXT("invalid maxbytes"), EAutomationExpectedErrorFlags::Contains, 3);
+					Exec(TEXT("gpa.StreamCapture start maxbytes=garbage"));
+					Exec(TEXT("gpa.StreamCapture start maxbytes=1.5X"));
+					Exec(TEXT("gpa.StreamCapture start maxbytes=-1"));
+					return true;
+				},
+				WaitFrames(3),
+				[this]()
+				{
+					TestEqual(TEXT("Capture state"), RuntimeModule->GetCaptureState().GetState(), EGPACaptureState::Idle);
+					TestEqual(TEXT("Start toggles"), CountTriggers(TEXT("start")), 0);
+					return true;
+				}
+			});
+		});
+
+		It("parses maxbytes= sizes", [this]()
+		{
+			uint64 Bytes = 0;
+			TestTrue(TEXT("500000"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("500000"), Bytes) && Bytes == 500000ull);
+			TestTrue(TEXT("512M"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("512M"), Bytes) && Bytes == 512ull * 1024 * 1024);
+			TestTrue(TEXT("1.5G"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("1.5G"), Bytes) && Bytes == 3ull * 512 * 1024 * 1024);
+			TestTrue(TEXT("2k"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("2k"), Bytes) && Bytes == 2048ull);
+			TestFalse(TEXT("empty"), FGPAPluginRuntimeModule::ParseByteSize(TEXT(""), Bytes));
+			TestFalse(TEXT("garbage"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("garbage"), Bytes));
+			TestFalse(TEXT("suffix only"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("G"), Bytes));
+			TestFalse(TEXT("negative"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("-1"), Bytes));
+			TestFalse(TEXT("exponent"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("1e9"), Bytes));
+			TestFalse(TEXT("two points"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("1.2.3M"), Bytes));
+			TestFalse(TEXT("unknown suffix"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("10T"), Bytes));
+			TestFalse(TEXT("zero"), FGPAPluginRuntimeModule::ParseByteSize(TEXT("0"), Bytes));
+		});
+	});
+
+	Describe("Toggle", [this]()
+	{
+		LatentIt("starts a capture and stops it on the next toggle", [this](const FDoneDelegate& Done)
+		{
+			// each toolbar click allocates a new token, the stop still ends the capture the toolbar started
+			auto Toggle = [this]()
+			{
+				FGPACaptureRequest Request = { FGPACaptureRequest::EType::Toggle, RuntimeModule->AllocateCaptureToken(EGPACaptureSource::Toolbar) };
+				Request.FrameCount = 0;
+				RuntimeModule->QueueCaptureRequest(Request);
+				return true;
+			};
+			RunSteps(Done, {
+				Toggle,
+				WaitForState(EGPACaptureState::Capturing),
+				[this]()
+				{
+					TestEqual(TEXT("Capture owner"), RuntimeModule->GetCaptureState().GetOwner().Source, EGPACaptureSource::Toolbar);
+					return true;
+				},
+				Toggle,
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					TestEqual(TEXT("Start toggles"), CountTriggers(TEXT("start")), 1);
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 1);
+					return true;
+				}
+			});
+		});
+	});
+
+	Describe("Ownership", [this]()
+	{
+		LatentIt("refuses to stop another source's capture unless forced", [this](const FDoneDelegate& Done)
+		{
+			TSharedRef<FGPACaptureToken> CodeToken = MakeShared<FGPACaptureToken>();
+			RunSteps(Done, {
+				[this, CodeToken]()
+				{
+					*CodeToken = RuntimeModule->AllocateCaptureToken(EGPACaptureSource::Code);
+					FGPACaptureRequest Request = { FGPACaptureRequest::EType::Start, *CodeToken };
+					Request.FrameCount = 0;
+					RuntimeModule->QueueCaptureRequest(Request);
+					return true;
+				},
+				WaitForState(EGPACaptureState::Capturing),
+				[this]()
+				{
+					// neither a plain console stop nor a toolbar toggle own the capture
+					Exec(TEXT("gpa.StreamCapture stop"));
+					RuntimeModule->QueueCaptureRequest({ FGPACaptureRequest::EType::Toggle, RuntimeModule->AllocateCaptureToken(EGPACaptureSource::Toolbar) });
+					return true;
+				},
+				WaitFrames(3),
+				[this, CodeToken]()
+				{
+					TestEqual(TEXT("Capture state"), RuntimeModule->GetCaptureState().GetState(), EGPACaptureState::Capturing);
+					TestTrue(TEXT("Capture owner"), RuntimeModule->GetCaptureState().GetOwner() == *CodeToken);
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 0);
+					Exec(TEXT("gpa.StreamCapture stop force"));
+					return true;
+				},
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					TestEqual(TEXT("Stop toggles"), CountTriggers(TEXT("stop")), 1);
+					return true;
+				}
+			});
+		});
+	});
+
+	Describe("Startup failure", [this]()
+	{
+		LatentIt("leaves capture unavailable when the shim fails to initialize at startup", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					AddExpectedError(TEXT("Failed to initialize GPA capture library"), EAutomationExpectedErrorFlags::Contains, 1);
+					RestartModule(OriginalCommandLine + TEXT(" -gpamockfail -gpaprearm"));
+					TestFalse(TEXT("Capture available"), RuntimeModule->IsCaptureAvailable());
+					TestNull(TEXT("Mock shim released"), FGPAMockShim::Get());
+					Exec(TEXT("gpa.StreamCapture start frames=0"));
+					return true;
+				},
+				WaitFrames(3),
+				[this]()
+				{
+					TestEqual(TEXT("Capture state"), RuntimeModule->GetCaptureState().GetState(), EGPACaptureState::Idle);
+					return true;
+				}
+			});
+		});
+
+		LatentIt("refuses the first capture when the lazily loaded shim fails to initialize", [this](const FDoneDelegate& Done)
+		{
+			RunSteps(Done, {
+				WaitForState(EGPACaptureState::Idle),
+				[this]()
+				{
+					AddExpectedError(TEXT("Failed to initialize GPA capture library"), EAutomationExpectedErrorFlags::Contains, 1);
+					SetConsoleVariable(TEXT("gpa.LazyLoad"), TEXT("1"));
+					RestartModule(OriginalCommandLine.Replace(TEXT("-gpaprearm"), TEXT("")) + TEXT(" -gpamockfail"));
+					TestTrue(TEXT("Capture available until the first request"), RuntimeModule->IsCaptureAvailable());
+					Exec(TEXT("gpa.StreamCapture start frames=0"));
+					return true;
+				},
+				WaitFrames(3),
+				[this]()
+				{
+					TestFalse(TEXT("Capture available"), RuntimeModule->IsCaptureAvailable());
+					TestEqual(TEXT("Capture state"), RuntimeModule->GetCaptureState().GetState(), EGPACaptureState::Idle);
+					return true;
+				}
+			});
+		});
+	});
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/** One capture in the catalog, a summary of its session sidecar**/
+struct FGPACaptureCatalogEntry
+{
+	/** Session sidecar file name, relative to the catalog directory**/
+	FString SessionFile;
+	/** Stream name in the stream directory, empty if the capture layer wrote none**/
+	FString Stream;
+	/** True once the disk budget deleted the stream, the session file stays**/
+	bool bEvicted = false;
+	FDateTime Time;
+	FString Map;
+	FString Build;
+	int32 Changelist = 0;
+	FString RHI;
+	FString Source;
+	int32 FrameCount = 0;
+	float MeanFrameMs = 0.0f;
+	float MaxFrameMs = 0.0f;
+	TArray<FString> Tags;
+};
+
+/**
+ * Index of every capture produced through the plugin, stored as one JSON line per capture next to the streams.
+ * Captures are appended as they finish and streams deleted by the disk budget are appended as eviction lines.
+ * The file is read once, on the capture worker at startup, into entries indexed by stream, map, build, RHI, source and tag,
+ * so lookups only visit the entries of the keys they filter on. Thread safe, entries are added from the capture worker.
+ */
+class GPAPLUGINRUNTIME_API FGPACaptureCatalog
+{
+public:
+	explicit FGPACaptureCatalog(const FString& InCatalogPath);
+
+	/** Reads the catalog file unless already done, called on the capture worker so the first lookup does not read it on the game thread**/
+	void Load() const;
+	/** Appends an entry to the catalog file and the loaded entries**/
+	void Add(const FGPACaptureCatalogEntry& Entry);
+	/** Appends one eviction line per stream and flags the entry that captured it**/
+	void MarkEvicted(const TArray<FString>& Streams);
+
+	/**
+	 * Newest entries first matching every term of Filter, at most MaxResults. Terms are key:value pairs
+	 * (map, build, rhi, source, tag, since:<yyyy-mm-dd>, minms:<mean frame ms>, evicted:<0|1>) or plain text matched against
+	 * map, build, source, tags and file name.
+	 */
+	TArray<FGPACaptureCatalogEntry> Find(const FString& Filter, int32 MaxResults = MAX_int32) const;
+
+	int32 Num() const;
+	const FString& GetCatalogPath() const { return CatalogPath; }
+
+	/** Broadcast on the game thread after an entry was added or evicted**/
+	DECLARE_MULTICAST_DELEGATE(FOnCatalogChanged);
+	FOnCatalogChanged& OnCatalogChanged() { return CatalogChangedDelegate; }
+
+	static FString ToJsonLine(const FGPACaptureCatalogEntry& Entry);
+	static bool FromJsonLine(const FString& Line, FGPACaptureCatalogEntry& OutEntry);
+	static FString ToEvictionLine(const FString& Stream);
+	static bool FromEvictionLine(const FString& Line, FString& OutStream);
+
+private:
+	/** Entry indices per key value, oldest first, keys compare case-insensitively**/
+	typedef TMap<FString, TArray<int32>> FKeyIndex;
+
+	/** Reads the catalog file on first access, CatalogLock must be held**/
+	void EnsureLoaded() const;
+	/** Appends an entry and adds it to the key indices, CatalogLock must be held**/
+	void AddEntry(FGPACaptureCatalogEntry&& Entry) const;
+	/** Flags the entry of a deleted stream, CatalogLock must be held**/
+	void ApplyEviction(const FString& Stream) const;
+	/** Broadcasts OnCatalogChanged on the game thread**/
+	static void BroadcastChanged();
+
+	FString CatalogPath;
+	mutable FCriticalSection CatalogLock;
+	mutable bool bLoaded;
+	/** Oldest first, in file order**/
+	mutable TArray<FGPACaptureCatalogEntry> Entries;
+	/** Entry that captured each stream, stream names are unique per capture**/
+	mutable TMap<FString, int32> StreamIndex;
+	mutable FKeyIndex MapIndex;
+	mutable FKeyIndex BuildIndex;
+	mutable TMap<int32, TArray<int32>> ChangelistIndex;
+	mutable FKeyIndex RHIIndex;
+	mutable FKeyIndex SourceIndex;
+	mutable FKeyIndex TagIndex;
+	FOnCatalogChanged CatalogChangedDelegate;
+};
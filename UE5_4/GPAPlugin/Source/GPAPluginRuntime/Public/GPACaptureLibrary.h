@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "GPACaptureState.h"
+#include "GPACaptureLibrary.generated.h"
+
+/** Blueprint handle to a capture started with StartGPACapture, needed to stop it**/
+USTRUCT(BlueprintType)
+struct GPAPLUGINRUNTIME_API FGPACaptureHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 TokenId = 0;
+};
+
+/** Starts and stops GPA stream captures from gameplay code through the plugin capture state machine**/
+UCLASS()
+class GPAPLUGINRUNTIME_API UGPACaptureLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/** True if the GPA shim is loaded and captures can be started**/
+	UFUNCTION(BlueprintPure, Category = "GPA")
+	static bool IsGPACaptureAvailable();
+
+	/** Current capture state, shared by all capture sources**/
+	UFUNCTION(BlueprintPure, Category = "GPA")
+	static EGPACaptureState GetGPACaptureState();
+
+	/**
+	 * Starts a stream capture on the next frame boundary.
+	 * @param FrameCount	Stop automatically after this many frames, 0 to run until StopGPACapture
+	 * @return Handle used to stop the capture, invalid if capture is not available
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GPA")
+	static FGPACaptureHandle StartGPACapture(int32 FrameCount = 0);
+
+	/** Stops the capture started with Handle, captures started by other sources are left running**/
+	UFUNCTION(BlueprintCallable, Category = "GPA")
+	static void StopGPACapture(const FGPACaptureHandle& Handle);
+};
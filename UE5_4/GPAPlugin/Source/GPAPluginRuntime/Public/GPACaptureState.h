@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "GPACaptureState.generated.h"
+
+/** Lifecycle of a GPA stream capture**/
+UENUM(BlueprintType)
+enum class EGPACaptureState : uint8
+{
+	/** No capture running, a new one can be started**/
+	Idle,
+	/** Start accepted, capture layer not yet triggered**/
+	Arming,
+	/** Capture layer is recording frames**/
+	Capturing,
+	/** Stop accepted, capture layer not yet triggered**/
+	Stopping,
+	/** Capture layer stopped, post capture work still running**/
+	Finalizing
+};
+
+/** Systems that can start and stop captures**/
+enum class EGPACaptureSource : uint8
+{
+	None,
+	Toolbar,
+	Console,
+	Blueprint,
+	/** FScopedGPACapture in C++ code**/
+	Code,
+	RemoteControl,
+	HitchMonitor,
+	Schedule,
+	CommandLine,
+	FlightRecorder,
+	Benchmark
+};
+
+/** Identifies the owner of a capture, only the owner can stop it unless the stop is forced**/
+struct FGPACaptureToken
+{
+	uint32 Id = 0;
+	EGPACaptureSource Source = EGPACaptureSource::None;
+
+	bool IsValid() const { return Id != 0; }
+	bool operator==(const FGPACaptureToken& Other) const { return Id == Other.Id; }
+	bool operator!=(const FGPACaptureToken& Other) const { return Id != Other.Id; }
+};
+
+/**
+ * Capture state and owner packed in a single atomic word, so every transition is one lock-free
+ * compare-exchange and querying the state each frame is a single load.
+ */
+class GPAPLUGINRUNTIME_API FGPACaptureStateMachine
+{
+public:
+	FGPACaptureStateMachine();
+
+	/** Creates a new owner token, can be called from any thread**/
+	FGPACaptureToken AllocateToken(EGPACaptureSource Source);
+
+	EGPACaptureState GetState() const { return UnpackState(PackedState.load(std::memory_order_acquire)); }
+	FGPACaptureToken GetOwner() const { return UnpackOwner(PackedState.load(std::memory_order_acquire)); }
+
+	/** True from the moment a start is accepted until a stop is accepted**/
+	bool IsCaptureActive() const
+	{
+		const EGPACaptureState State = GetState();
+		return State == EGPACaptureState::Arming || State == EGPACaptureState::Capturing;
+	}
+
+	/** Idle -> Arming, the token becomes the owner of the capture**/
+	bool TryArm(const FGPACaptureToken& Token);
+	/** Arming or Capturing -> Stopping for the capture owned by Token**/
+	bool TryBeginStop(const FGPACaptureToken& Token);
+	/** Moves the capture owned by Token from one state to another, the owner is released when reaching Idle**/
+	bool TryTransition(const FGPACaptureToken& Token, EGPACaptureState From, EGPACaptureState To);
+
+	static const TCHAR* ToString(EGPACaptureState State);
+	static const TCHAR* ToString(EGPACaptureSource Source);
+
+private:
+	static uint64 Pack(EGPACaptureState State, const FGPACaptureToken& Owner)
+	{
+		return (uint64)State | ((uint64)Owner.Source << 8) | ((uint64)Owner.Id << 32);
+	}
+	static EGPACaptureState UnpackState(uint64 Packed) { return (EGPACaptureState)(Packed & 0xff); }
+	static FGPACaptureToken UnpackOwner(uint64 Packed)
+	{
+		FGPACaptureToken Owner;
+		Owner.Id = (uint32)(Packed >> 32);
+		Owner.Source = (EGPACaptureSource)((Packed >> 8) & 0xff);
+		return Owner;
+	}
+
+	std::atomic<uint64> PackedState;
+	std::atomic<uint32> NextTokenId;
+};
@@ -0,0 +1,297 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+#include "Containers/Queue.h"
+#include "GPACaptureState.h"
+#include <atomic>
+
+THIRD_PARTY_INCLUDES_START
+#include <igpa-shim-loader.h>
+#include <igpa-config.h>
+#if !PLATFORM_WINDOWS
+// outside Windows igpa-config.h maps TCHAR to char, which would shadow the engine character type
+#undef TCHAR
+#undef _T
+#undef _tmain
+#endif
+THIRD_PARTY_INCLUDES_END
+
+GPAPLUGINRUNTIME_API DECLARE_LOG_CATEGORY_EXTERN(GPAPlugin, Log, All);
+
+class FGPAHitchMonitor;
+class FGPACaptureScheduler;
+class FGPACaptureWorker;
+class FGPABenchmark;
+class FGPACaptureSession;
+class FGPACaptureCatalog;
+class FGPADiskBudget;
+class FGPALayerParameterCheck;
+class IGPAProcessTracker;
+
+/** Outcome of a capture start, busy starts can be retried while failed ones would fail the same way again**/
+enum class EGPACaptureStartResult : uint8
+{
+	Started,
+	/** Another capture owns the session**/
+	Busy,
+	/** Capture is not possible, e.g. unsupported RHI, GPA not loaded or too little disk space**/
+	Failed
+};
+
+/** Capture control request, queued from any thread and applied on the next frame boundary**/
+struct FGPACaptureRequest
+{
+	enum class EType : uint8
+	{
+		Start,
+		Stop,
+		/** Stop if running, start otherwise, as done by the toolbar button**/
+		Toggle,
+		DumpFlightRecorder
+	};
+
+	EType Type;
+	/** Owner of the capture to start, or of the capture to stop**/
+	FGPACaptureToken Token;
+	/** Frames to capture for Start and Toggle, 0 if unbounded, negative to use gpa.FrameCaptureCount**/
+	int32 FrameCount = INDEX_NONE;
+	/** Stream size and wall time after which a capture started by Start or Toggle stops, 0 if unbounded**/
+	uint64 MaxBytes = 0;
+	double MaxSeconds = 0.0;
+	/** Stop the running capture even if it is owned by another token**/
+	bool bForce = false;
+};
+
+/**
+ * Loads the GPA shim and owns capture control: console commands, capture state and automatic triggers.
+ * Available in editor and in non-shipping packaged builds, editor UI lives in the GPAPlugin module.
+ */
+class GPAPLUGINRUNTIME_API FGPAPluginRuntimeModule : public IModuleInterface
+{
+public:
+	FGPAPluginRuntimeModule() : gpa(nullptr), bAllThirdPartyLibsLoaded(false), bLazyLoadPending(false), bUseMockShim(false), bCaptureLayerDeferred(true), ShimHookApiMask(0), bStreamDirectoryIgnored(false), bFlightRecorderActive(false), bFlightRecorderRearmPending(false), bArmingGatePending(false), ArmingStartTime(0.0), ArmingNotificationTime(0.0), FramesToCapture(0), MaxCaptureBytes(0), MaxCaptureSeconds(0.0), CaptureStartTime(0.0), CapturedFrames(0), ArmedFrameCounter(0), CommandLineCaptureFrame(INDEX_NONE), CommandLineCaptureCount(0), NumPendingCaptureRequests(0), FlightRecorderArmedFrame(0) {};
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+	
+	/** Runtime module instance, loads the module if needed**/
+	static FGPAPluginRuntimeModule& Get()
+	{
+		return FModuleManager::LoadModuleChecked<FGPAPluginRuntimeModule>("GPAPluginRuntime");
+	}
+
+	/** True once the GPA shim is loaded, or can be loaded on the first capture request, and captures can be requested**/
+	bool IsCaptureAvailable() const { return gpa != nullptr || bLazyLoadPending; }
+
+	/** APIs the GPA shim hooks, see gpa.HookApiMask**/
+	static gpa::utility::HookApiFlags GetHookApiMask();
+	/** Hook mask the shim was initialized with, 0 while it is not**/
+	uint32 GetShimHookApiMask() const { return ShimHookApiMask; }
+
+	/** Absolute directory session files, the capture catalog and benchmark results are written to, see gpa.CaptureOutputDirectory**/
+	static FString GetCaptureOutputDirectory();
+	/** Streams subdirectory of the capture output directory the capture layer writes to, it holds nothing but streams**/
+	static FString GetStreamDirectory();
+
+	/** Parses a byte count with an optional K, M or G suffix, e.g. 512M or 1.5G, returns false if Text is anything else**/
+	static bool ParseByteSize(const FString& Text, uint64& OutBytes);
+
+	/** Index of the captures in the capture output directory, null before startup**/
+	FGPACaptureCatalog* GetCaptureCatalog() const { return CaptureCatalog.Get(); }
+
+	/** Broadcast on the game thread for every user facing capture message, the editor shows them as notifications**/
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnCaptureNotification, const FString& /*Info*/);
+	FOnCaptureNotification& OnCaptureNotification() { return CaptureNotificationDelegate; }
+
+	/** Queues a capture control request, can be called from any thread without blocking**/
+	void QueueCaptureRequest(const FGPACaptureRequest& Request);
+
+	/** Current capture state and owner, cheap enough to query every frame from any thread**/
+	const FGPACaptureStateMachine& GetCaptureState() const { return CaptureState; }
+	/** Creates an owner token for a capture started by Source**/
+	FGPACaptureToken AllocateCaptureToken(EGPACaptureSource Source) { return CaptureState.AllocateToken(Source); }
+	
+private:
+	/** pointer to GPA interface, use GetGPAInterface to retrieve it**/
+	IGPA* gpa;
+
+	bool bAllThirdPartyLibsLoaded;
+	/** GPA install was found at startup, libraries are loaded and the shim initialized on the first capture request**/
+	bool bLazyLoadPending;
+	/** -gpamock replaces the GPA shim with FGPAMockShim, for runs without GPA install or GPU**/
+	bool bUseMockShim;
+	/** Value of the capture layer "deferred" parameter, only turned off by benchmark runs**/
+	bool bCaptureLayerDeferred;
+	/** Hook mask and capture layer parameters passed to the shim, recorded in session sidecars**/
+	uint32 ShimHookApiMask;
+	TArray<TPair<FString, FString>> ShimLayerParameters;
+	/** Directory holding the GPA libraries, resolved at startup**/
+	FString LibraryPath;
+	/** Set by the capture worker once the capture layer evidently ignores output-dir, the disk budget, gpa.PinStream
+	    and maxbytes= are disabled since the stream directory stays empty**/
+	std::atomic<bool> bStreamDirectoryIgnored;
+
+	/** Lock-free capture state and owner, transitions to Capturing and Finalizing happen on the render thread**/
+	FGPACaptureStateMachine CaptureState;
+
+	// state below is only accessed on the game thread, other threads go through QueueCaptureRequest
+	/** Last captures started from the console and the toolbar, a plain stop from either only ends its own**/
+	FGPACaptureToken ConsoleToken;
+	FGPACaptureToken ToolbarToken;
+	/** Set while the deferred capture runs continuously as a flight recorder**/
+	bool bFlightRecorderActive;
+	/** Flight recorder was dumped and restarts on the next frame boundary**/
+	bool bFlightRecorderRearmPending;
+
+	/** Capture is armed but its start is held back until rendering settles, see FGPAArmingGate**/
+	bool bArmingGatePending;
+	/** Time the held back capture was armed and its last progress notification**/
+	double ArmingStartTime;
+	double ArmingNotificationTime;
+
+	/** Number of frames after which a running capture stops on its own, 0 if unbounded**/
+	int32 FramesToCapture;
+	/** Stream size and wall time after which a running capture stops on its own, 0 if unbounded**/
+	uint64 MaxCaptureBytes;
+	double MaxCaptureSeconds;
+	/** Time the running capture triggered**/
+	double CaptureStartTime;
+	/** Number of frames rendered since the running capture started**/
+	int32 CapturedFrames;
+	/** Engine frame on whose boundary the running capture was started**/
+	uint64 ArmedFrameCounter;
+	/** Engine frame at which the -gpacapture capture starts, INDEX_NONE once started or if not requested**/
+	int64 CommandLineCaptureFrame;
+	/** Number of frames captured by the -gpacapture capture**/
+	int32 CommandLineCaptureCount;
+	/** Frame-end hook applying queued requests and counting captured frames**/
+	FDelegateHandle EndFrameHandle;
+
+	/** Lock-free queue of capture requests from console, toolbar and other sources**/
+	TQueue<FGPACaptureRequest, EQueueMode::Mpsc> CaptureRequests;
+	/** Lets the frame-end hook skip the queue while it is empty**/
+	std::atomic<int32> NumPendingCaptureRequests;
+	/** Runs blocking capture control work off the game thread**/
+	TUniquePtr<FGPACaptureWorker> CaptureWorker;
+	/** Deferred flight recorder start, waiting for the RHI to be created**/
+	FDelegateHandle PostEngineInitHandle;
+	/** Owner of the continuous flight recorder capture**/
+	FGPACaptureToken FlightRecorderToken;
+	/** Engine frame the flight recorder was last armed on, a dump holds no frames before it**/
+	uint64 FlightRecorderArmedFrame;
+
+	/** Graphics Monitor launched after capture, only used on the capture worker**/
+	TUniquePtr<IGPAProcessTracker> GraphicsMonitorProcess;
+	/** Checks the streams for capture layer parameters the shim silently ignored, only used on the capture worker**/
+	TUniquePtr<FGPALayerParameterCheck> LayerParameterCheck;
+
+	/** Starts a bounded capture when frame time spikes, see gpa.HitchThresholdMs**/
+	TUniquePtr<FGPAHitchMonitor> HitchMonitor;
+	/** Runs unattended capture windows from gpa.CaptureSchedule or -gpaschedule=**/
+	TUniquePtr<FGPACaptureScheduler> CaptureScheduler;
+	/** Metadata of the running capture, handed to the worker for the sidecar when it stops**/
+	TSharedPtr<FGPACaptureSession, ESPMode::ThreadSafe> ActiveSession;
+	/** Index of finished captures, updated on the worker as each capture completes**/
+	TUniquePtr<FGPACaptureCatalog> CaptureCatalog;
+	/** Keeps the capture output directory within its disk budget, created with the capture worker**/
+	TUniquePtr<FGPADiskBudget> DiskBudget;
+	/** Measures plugin overhead for -gpabenchmark= runs**/
+	TUniquePtr<FGPABenchmark> Benchmark;
+	/** Owner of the capture measured by the benchmark**/
+	FGPACaptureToken BenchmarkToken;
+
+	/** Handles to the third party dlls that were set for delayed loading**/
+	TArray<void*> ThirdPartyLibraryHandles;
+
+	FOnCaptureNotification CaptureNotificationDelegate;
+
+	/** Resolves the GPA install directory from settings or registry without loading anything, returns false if not found**/
+	bool FindThirdPartyLibraries();
+	/** Loads all dlls required by the GPA API capture tool**/
+	void LoadThirdPartyLibraries();
+	/** Adds a capture layer parameter and records it for the session sidecars**/
+	void AddCaptureLayerParameter(const char* Key, const char* Value);
+	/** Creates the shim interface, adds the capture layer and initializes it, returns false if GPA is unusable**/
+	bool InitializeGPA();
+	/** Loads and initializes GPA if startup deferred it, game thread only**/
+	bool EnsureGPAInitialized();
+	/** Releases GPA related libraries**/
+	void FreeThirdPartyLibraries();
+	/** Callback for stream capture event**/
+	void CaptureStream(const TArray<FString>& Args);
+	/** Starts stream capture owned by Token, stops automatically after FrameCount frames unless FrameCount is 0,
+	    negative FrameCount uses the project setting, and once the stream reaches MaxBytes or runs MaxSeconds if set**/
+	EGPACaptureStartResult StartStreamCapture(const FGPACaptureToken& Token, int32 FrameCount, uint64 MaxBytes = 0, double MaxSeconds = 0.0);
+	/** Stops the running capture through the normal stop path once its size or time limit is reached**/
+	void TickCaptureLimits();
+	/** Stops running stream capture if owned by Token or if forced**/
+	bool StopStreamCapture(const FGPACaptureToken& Token, bool bForce);
+	/** Switches the RHI to ideal capture conditions if the active capture backend uses them**/
+	void EnableIdealGPUCaptureOptions(bool bEnable);
+	/** Triggers the armed capture once the arming gate opens or times out, shows progress while waiting**/
+	void TickArmingGate();
+	/** Looks up the capture layer parameters the plugin sets in gpa-help of the install, capture worker only**/
+	void CheckLayerParameters();
+	/** Turns off everything that relies on streams appearing in the stream directory, capture worker only**/
+	void DisableStreamDirectory(const FString& Reason);
+	/** Indexes the stream directory and marks streams evicted to stay within the disk budget in the catalog, capture worker only**/
+	void UpdateDiskBudget();
+	/** Runs on the worker once the capture layer stopped, returns the state machine to Idle**/
+	void FinalizeStreamCapture(const FGPACaptureToken& Token, bool bRunGraphicsMonitor, TSharedPtr<FGPACaptureSession, ESPMode::ThreadSafe> Session);
+	/** Applies queued capture requests and stops frame-bounded captures once the requested count is reached**/
+	void OnEndFrame();
+	/** Applies all queued capture requests, game thread only**/
+	void ProcessCaptureRequests();
+	/** Emits the capture start/stop event from the render thread, in order with frame commands,
+	    and completes the Arming or Stopping transition once the event is emitted**/
+	void TriggerStreamCaptureOnRenderThread(const FGPACaptureToken& Token, EGPACaptureState From, EGPACaptureState To, bool bRunGraphicsMonitor = false,
+		TSharedPtr<FGPACaptureSession, ESPMode::ThreadSafe> Session = nullptr);
+	/** Starts the continuous deferred capture used as flight recorder**/
+	void StartFlightRecorder();
+	/** Writes the frames held by the flight recorder to disk and re-arms it, returns false if nothing was written**/
+	bool DumpFlightRecorder();
+	/** Callback for flight recorder console command**/
+	void FlightRecorderCommand(const TArray<FString>& Args);
+	/** Parses -gpacapture=start:<frame>,count:<n>,out:<dir>, returns true if a capture was requested**/
+	bool ParseCommandLineCapture();
+	/** Starts the command line capture once its start frame is reached**/
+	void TickCommandLineCapture();
+	/** Called by the hitch monitor when frame time stayed above threshold, returns true if frames were captured**/
+	bool OnHitchDetected(const FString& Reason);
+	/** Called by the benchmark around the measured frames of the capture configuration**/
+	bool OnBenchmarkStartCapture();
+	void OnBenchmarkStopCapture();
+	/** Called by the capture scheduler when a capture window is due**/
+	EGPACaptureStartResult OnScheduledCapture(int32 FrameCount);
+	/** Callback for the stream pinning console command**/
+	void PinStreamCommand(const TArray<FString>& Args);
+	/** Callback for the capture catalog console command**/
+	void ListCapturesCommand(const TArray<FString>& Args, FOutputDevice& Ar);
+	/** Function handling on screen notification, forwarded to the editor when it listens**/
+	void ShowNotification(const FString& Info);
+	/** Start Graphics Monitor as a new process**/
+	void StartGraphicsMonitorProcess();
+};
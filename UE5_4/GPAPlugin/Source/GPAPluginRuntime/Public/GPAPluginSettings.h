@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "Engine/DeveloperSettings.h"
+#include "GPAPluginSettings.generated.h"
+
+/** APIs hooked by the GPA shim, values match gpa::utility::HookApiFlagBits**/
+UENUM(meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EGPAHookApi : int32
+{
+	None = 0 UMETA(Hidden),
+	D3D10 = 1 << 0,
+	D3D11 = 1 << 1,
+	D3D12 = 1 << 2,
+	Vulkan = 1 << 3,
+	OpenGL = 1 << 5,
+	OpenCL = 1 << 6,
+	Win32 = 1 << 10
+};
+
+UCLASS(config = Engine, defaultconfig, meta = (DisplayName = "GPA"))
+class GPAPLUGINRUNTIME_API UGPAPluginSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(config, EditAnywhere, Category = "General", meta = (
+		ConsoleVariable = "gpa.BinaryLocation", DisplayName = "GPA binary location",
+		ToolTip = "Path that will be used to locate GPA Framework binaries, typically C:\\Program Files\\IntelSWTools\\GPA Framework\\<version>\\bin\\Release. On Linux $INTEL_GPA_FRAMEWORK/bin is used if not set",
+		ConfigRestartRequired = true))
+		FString GPABinaryPath;
+	UPROPERTY(config, EditAnywhere, Category = "General", meta = (
+		ConsoleVariable = "gpa.HookApiMask", DisplayName = "Hooked APIs",
+		ToolTip = "APIs hooked by the GPA shim. If none are selected the active RHI and, on Windows, Win32 are hooked, hooking fewer APIs reduces shim startup time and per-call overhead",
+		Bitmask, BitmaskEnum = "/Script/GPAPluginRuntime.EGPAHookApi",
+		ConfigRestartRequired = true))
+		int32 HookApiMask;
+	UPROPERTY(config, EditAnywhere, Category = "General", meta = (
+		ConsoleVariable = "gpa.LazyLoad", DisplayName = "Load GPA on first capture",
+		ToolTip = "If checked only the GPA install location is verified at startup, libraries are loaded and the shim initialized on the first capture request. APIs initialized before that are not hooked, use -gpaprearm to load at startup for a single session",
+		ConfigRestartRequired = true))
+		bool bLazyLoad;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.CaptureOutputDirectory", DisplayName = "Capture output directory",
+		ToolTip = "Directory session files and the capture catalog are written to, GPA streams go to its Streams subdirectory. Relative paths are resolved against the project directory. Defaults to Saved/GPA. Overridden by -gpacapture=...,out:<dir>",
+		ConfigRestartRequired = true))
+		FString CaptureOutputDirectory;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.CaptureDiskBudgetGB", DisplayName = "Capture disk budget (GB)",
+		ToolTip = "If 0 the stream directory is unbounded, otherwise the least recently written streams not pinned with gpa.PinStream are deleted once captures exceed this size, and a capture that would not fit is stopped",
+		ClampMin = 0,
+		ConfigRestartRequired = false))
+		float CaptureDiskBudgetGB;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.MinFreeDiskSpaceGB", DisplayName = "Minimum free disk space (GB)",
+		ToolTip = "Captures do not start, and running captures stop, when the capture output volume has less free space than this",
+		ClampMin = 0,
+		ConfigRestartRequired = false))
+		float MinFreeDiskSpaceGB;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.FrameCaptureCount", DisplayName = "Number of frames to be captured",
+		ToolTip = "If 0 the capture will run until explicitly stopped, otherwise it will automatically stop after reaching specified number of frames",
+		ClampMin = 0,
+		ConfigRestartRequired = false))
+		int32 FrameCaptureCount;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.FlightRecorderFrames", DisplayName = "Flight recorder frames",
+		ToolTip = "If 0 the flight recorder is disabled, otherwise the deferred capture runs continuously keeping the last N frames which are written to disk by gpa.FlightRecorder dump or the toolbar button. The ring is best-effort: it relies on a capture layer parameter the GPA shim cannot confirm, the log tells at startup whether gpa-help lists it",
+		ClampMin = 0,
+		ConfigRestartRequired = true))
+		int32 FlightRecorderFrames;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.CaptureSchedule", DisplayName = "Capture schedule file",
+		ToolTip = "Path to a JSON file listing capture windows triggered by frame number, elapsed time or map load, each with a frame count. Overridden by -gpaschedule=<path>",
+		ConfigRestartRequired = true))
+		FString CaptureSchedule;
+	UPROPERTY(config, EditAnywhere, Category = "Capture Arming Settings", meta = (
+		ConsoleVariable = "gpa.ArmWaitForCompilation", DisplayName = "Wait for shader and PSO compilation",
+		ToolTip = "If checked a requested capture only starts once shader compilation and PSO precaching have drained, so the stream shows steady-state rendering. Hitch-triggered, scoped, scheduled, command line and benchmark captures start immediately",
+		ConfigRestartRequired = false))
+		bool bArmWaitForCompilation;
+	UPROPERTY(config, EditAnywhere, Category = "Capture Arming Settings", meta = (
+		ConsoleVariable = "gpa.ArmWaitForStreaming", DisplayName = "Wait for streaming",
+		ToolTip = "If checked a requested capture only starts once World Partition and level streaming, async loading and texture streaming are done, so traversal I/O and mip uploads stay out of the stream",
+		ConfigRestartRequired = false))
+		bool bArmWaitForStreaming;
+	UPROPERTY(config, EditAnywhere, Category = "Capture Arming Settings", meta = (
+		ConsoleVariable = "gpa.ArmTimeoutSeconds", DisplayName = "Arming timeout (s)",
+		ToolTip = "Maximum time a capture waits for rendering to settle before it starts anyway",
+		ClampMin = 0,
+		ConfigRestartRequired = false))
+		float ArmTimeoutSeconds;
+	UPROPERTY(config, EditAnywhere, Category = "Hitch Capture Settings", meta = (
+		ConsoleVariable = "gpa.HitchThresholdMs", DisplayName = "Hitch threshold (ms)",
+		ToolTip = "If 0 hitch-triggered capture is disabled, otherwise a capture starts when game thread, render thread or GPU frame time exceeds this value",
+		ClampMin = 0,
+		ConfigRestartRequired = false))
+		float HitchThresholdMs;
+	UPROPERTY(config, EditAnywhere, Category = "Hitch Capture Settings", meta = (
+		ConsoleVariable = "gpa.HitchFrames", DisplayName = "Consecutive hitch frames",
+		ToolTip = "Number of consecutive frames above the threshold required to trigger a capture",
+		ClampMin = 1,
+		ConfigRestartRequired = false))
+		int32 HitchFrames;
+	UPROPERTY(config, EditAnywhere, Category = "Hitch Capture Settings", meta = (
+		ConsoleVariable = "gpa.HitchCooldownSeconds", DisplayName = "Cooldown (s)",
+		ToolTip = "Minimum time between two hitch-triggered captures, so one hitch storm produces one capture",
+		ClampMin = 0,
+		ConfigRestartRequired = false))
+		float HitchCooldownSeconds;
+	UPROPERTY(config, EditAnywhere, Category = "Hitch Capture Settings", meta = (
+		ConsoleVariable = "gpa.HitchCaptureFrames", DisplayName = "Frames captured per hitch",
+		ToolTip = "Number of frames captured when a hitch is detected",
+		ClampMin = 1,
+		ConfigRestartRequired = false))
+		int32 HitchCaptureFrames;
+	UPROPERTY(config, EditAnywhere, Category = "Stream Capture Settings", meta = (
+		ConsoleVariable = "gpa.RunGPAAfterCapture", DisplayName = "Run GPA after capture complete",
+		ToolTip = "If checked the GPA UI will automatically start after the capture is complete.",
+		ConfigRestartRequired = false))
+		bool bRunGPAAfterCapture;
+
+public:
+	virtual void PostInitProperties() override;
+	virtual FName GetCategoryName() const;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+};
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// WITH_GPA_CAPTURE is defined by the GPAPluginRuntime module rules for builds that can capture
+#ifndef WITH_GPA_CAPTURE
+#define WITH_GPA_CAPTURE 0
+#endif
+
+#if WITH_GPA_CAPTURE
+
+#include "GPACaptureState.h"
+
+/**
+ * Captures the frames spanned by its lifetime: the capture starts on the frame boundary following
+ * construction and stops on the boundary following destruction, covering at least one frame.
+ * Does nothing if GPA is not loaded or another source already owns the running capture.
+ */
+class GPAPLUGINRUNTIME_API FScopedGPACapture
+{
+public:
+	FScopedGPACapture(int32 MaxFrameCount = 0);
+	~FScopedGPACapture();
+
+	FScopedGPACapture(const FScopedGPACapture&) = delete;
+	FScopedGPACapture& operator=(const FScopedGPACapture&) = delete;
+
+private:
+	FGPACaptureToken Token;
+};
+
+#define GPA_SCOPED_CAPTURE(...) FScopedGPACapture PREPROCESSOR_JOIN(GPAScopedCapture_, __LINE__)(__VA_ARGS__)
+
+#else
+
+#define GPA_SCOPED_CAPTURE(...)
+
+#endif // WITH_GPA_CAPTURE
@@ -11,15 +11,7 @@ public class GPALibrary : ModuleRules
 
 		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "include"));
 
-		if (Target.Platform == UnrealTargetPlatform.Win64)
-		{
-			// Add the import library
-			PublicAdditionalLibraries.Add(Path.Combine(ModuleDirectory, "lib", "igpa-shim-loader-x64.lib"));
-
-			// Delay-load the DLLs, StartupModule() will load the them from the correct location
-			PublicDelayLoadDLLs.Add("logger-x64.dll");
-			PublicDelayLoadDLLs.Add("runtime-x64.dll");
-			PublicDelayLoadDLLs.Add("igpa-shim-loader-x64.dll");
-		}
+		// Nothing is linked, on Win64 and Linux StartupModule() loads the GPA libraries from the install location
+		// and resolves GetGPAInterface from the shim loader at runtime
 	}
 }